@@ -0,0 +1,151 @@
+/*
+ * Honggfuzz+ - keyed AES decryption rounds over 16-byte blocks
+ * -----------------------------------------
+ *
+ * Each round is AESDEC (InvShiftRows, InvSubBytes, InvMixColumns, AddRoundKey), the last one is
+ * AESDECLAST (no InvMixColumns). With AES-NI a block round is a single instruction; otherwise the
+ * same transformation is computed with the reverse S-box and a 256-entry InvMixColumns table, so
+ * both paths produce identical output for the same key.
+ */
+
+#ifndef _HF_AESROUND_H_
+#define _HF_AESROUND_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "memswap.h"
+
+#if defined(_HF_MEMSWAP_X86)
+#define HF_ATTR_AESNI __attribute__((target("aes,sse2")))
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+#define AESROUND_BLOCK_SZ   16U
+#define AESROUND_MAX_ROUNDS 14U
+
+typedef struct {
+    uint8_t  rk[AESROUND_MAX_ROUNDS][AESROUND_BLOCK_SZ];
+    unsigned rounds;
+} aesround_key_t;
+
+/*
+ * aesround_td[x] holds InvMixColumns applied to a column with a single non-zero byte
+ * S^-1(x) in row 0: bytes (14, 9, 13, 11) * S^-1(x), least significant byte first
+ */
+static uint32_t aesround_td[256];
+
+static inline uint8_t aesround_xtime(uint8_t x) {
+    return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00));
+}
+
+static inline uint8_t aesround_gmul(uint8_t x, uint8_t y) {
+    uint8_t res = 0;
+    for (; y; y >>= 1) {
+        if (y & 1) {
+            res ^= x;
+        }
+        x = aesround_xtime(x);
+    }
+    return res;
+}
+
+__attribute__((constructor)) static void aesround_init(void) {
+    for (unsigned x = 0; x < 256; x++) {
+        uint8_t s      = memswap_sbox[x];
+        aesround_td[x] = (uint32_t)aesround_gmul(s, 14) | (uint32_t)aesround_gmul(s, 9) << 8 |
+                         (uint32_t)aesround_gmul(s, 13) << 16 | (uint32_t)aesround_gmul(s, 11) << 24;
+    }
+}
+
+static inline uint32_t aesround_rotl32(uint32_t x, unsigned k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+/* One AESDEC/AESDECLAST round on a single block, state is column-major as in FIPS-197 */
+static inline void aesround_tableRound(uint8_t blk[16], const uint8_t rk[16], bool last) {
+    uint8_t in[16];
+    memcpy(in, blk, sizeof(in));
+    for (unsigned c = 0; c < 4; c++) {
+        /* InvShiftRows: row r is rotated right by r columns */
+        uint8_t a0 = in[0 + 4 * c];
+        uint8_t a1 = in[1 + 4 * ((c + 3) & 3)];
+        uint8_t a2 = in[2 + 4 * ((c + 2) & 3)];
+        uint8_t a3 = in[3 + 4 * ((c + 1) & 3)];
+        if (last) {
+            blk[0 + 4 * c] = memswap_sbox[a0] ^ rk[0 + 4 * c];
+            blk[1 + 4 * c] = memswap_sbox[a1] ^ rk[1 + 4 * c];
+            blk[2 + 4 * c] = memswap_sbox[a2] ^ rk[2 + 4 * c];
+            blk[3 + 4 * c] = memswap_sbox[a3] ^ rk[3 + 4 * c];
+            continue;
+        }
+        uint32_t col = aesround_td[a0] ^ aesround_rotl32(aesround_td[a1], 8) ^
+                       aesround_rotl32(aesround_td[a2], 16) ^ aesround_rotl32(aesround_td[a3], 24);
+        blk[0 + 4 * c] = (uint8_t)(col) ^ rk[0 + 4 * c];
+        blk[1 + 4 * c] = (uint8_t)(col >> 8) ^ rk[1 + 4 * c];
+        blk[2 + 4 * c] = (uint8_t)(col >> 16) ^ rk[2 + 4 * c];
+        blk[3 + 4 * c] = (uint8_t)(col >> 24) ^ rk[3 + 4 * c];
+    }
+}
+
+static inline void aesround_table(uint8_t* data, size_t nblocks, const aesround_key_t* key) {
+    for (size_t b = 0; b < nblocks; b++) {
+        uint8_t* blk = &data[b * AESROUND_BLOCK_SZ];
+        for (unsigned r = 0; r < key->rounds; r++) {
+            aesround_tableRound(blk, key->rk[r], /* last= */ (r + 1) == key->rounds);
+        }
+    }
+}
+
+#if defined(_HF_MEMSWAP_X86)
+
+/* AESDEC has a latency of several cycles but a throughput of ~1, so interleave 4 blocks */
+HF_ATTR_AESNI static void aesround_aesni(uint8_t* data, size_t nblocks, const aesround_key_t* key) {
+    __m128i rk[AESROUND_MAX_ROUNDS];
+    for (unsigned r = 0; r < key->rounds; r++) {
+        rk[r] = _mm_loadu_si128((const __m128i*)key->rk[r]);
+    }
+    const unsigned last = key->rounds - 1;
+
+    size_t b = 0;
+    for (; (b + 4) <= nblocks; b += 4) {
+        __m128i* p  = (__m128i*)&data[b * AESROUND_BLOCK_SZ];
+        __m128i  v0 = _mm_loadu_si128(&p[0]);
+        __m128i  v1 = _mm_loadu_si128(&p[1]);
+        __m128i  v2 = _mm_loadu_si128(&p[2]);
+        __m128i  v3 = _mm_loadu_si128(&p[3]);
+        for (unsigned r = 0; r < last; r++) {
+            v0 = _mm_aesdec_si128(v0, rk[r]);
+            v1 = _mm_aesdec_si128(v1, rk[r]);
+            v2 = _mm_aesdec_si128(v2, rk[r]);
+            v3 = _mm_aesdec_si128(v3, rk[r]);
+        }
+        _mm_storeu_si128(&p[0], _mm_aesdeclast_si128(v0, rk[last]));
+        _mm_storeu_si128(&p[1], _mm_aesdeclast_si128(v1, rk[last]));
+        _mm_storeu_si128(&p[2], _mm_aesdeclast_si128(v2, rk[last]));
+        _mm_storeu_si128(&p[3], _mm_aesdeclast_si128(v3, rk[last]));
+    }
+    for (; b < nblocks; b++) {
+        __m128i* p = (__m128i*)&data[b * AESROUND_BLOCK_SZ];
+        __m128i  v = _mm_loadu_si128(p);
+        for (unsigned r = 0; r < last; r++) {
+            v = _mm_aesdec_si128(v, rk[r]);
+        }
+        _mm_storeu_si128(p, _mm_aesdeclast_si128(v, rk[last]));
+    }
+}
+
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+/* Runs key->rounds (1..AESROUND_MAX_ROUNDS) decryption rounds in place over 'nblocks' blocks */
+static inline void aesround_decrypt(uint8_t* data, size_t nblocks, const aesround_key_t* key) {
+#if defined(_HF_MEMSWAP_X86)
+    if (__builtin_cpu_supports("aes")) {
+        aesround_aesni(data, nblocks, key);
+        return;
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    aesround_table(data, nblocks, key);
+}
+
+#endif /* _HF_AESROUND_H_ */
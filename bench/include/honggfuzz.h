@@ -0,0 +1,71 @@
+/*
+ * Honggfuzz+ - minimal stand-in for honggfuzz.h, for the mangle benchmark
+ * -----------------------------------------
+ *
+ * Only the fields used by mangle.c are kept, with the same names and types as in honggfuzz.
+ */
+
+#ifndef _HF_HONGGFUZZ_H_
+#define _HF_HONGGFUZZ_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define _HF_INPUT_MAX_SIZE (1024ULL * 1024ULL)
+
+typedef enum {
+    _HF_DYNFILE_NONE         = 0x0,
+    _HF_DYNFILE_INSTR_COUNT  = 0x1,
+    _HF_DYNFILE_BRANCH       = 0x2,
+    _HF_DYNFILE_BTS_EDGE     = 0x10,
+    _HF_DYNFILE_IPT_BLOCK    = 0x20,
+    _HF_DYNFILE_SOFT         = 0x40,
+} dynFileMethod_t;
+
+typedef struct {
+    uint32_t cnt;
+    struct {
+        uint8_t  val[32];
+        uint32_t len;
+    } valArr[1024 * 16];
+} cmpfeedback_t;
+
+typedef struct {
+    struct {
+        bool only_printable;
+    } cfg;
+    struct {
+        unsigned mutationsPerRun;
+        size_t   maxInputSz;
+        struct {
+            uint8_t val[256];
+            size_t  len;
+        } dictionary[1024];
+        size_t      dictionaryCnt;
+        const char* dictionaryFile;
+    } mutate;
+    struct {
+        time_t lastCovUpdate;
+    } timing;
+    struct {
+        cmpfeedback_t*  cmpFeedbackMap;
+        bool            cmpFeedback;
+        dynFileMethod_t dynFileMethod;
+    } feedback;
+} honggfuzz_t;
+
+typedef struct _dynfile_t {
+    size_t   size;
+    uint8_t* data;
+} dynfile_t;
+
+typedef struct {
+    honggfuzz_t* global;
+    dynfile_t*   dynfile;
+    unsigned     mutationsPerRun;
+} run_t;
+
+#endif /* _HF_HONGGFUZZ_H_ */
@@ -0,0 +1,30 @@
+/*
+ * Honggfuzz+ - minimal stand-in for input.h, for the mangle benchmark
+ * -----------------------------------------
+ *
+ * The corpus is a single buffer (queue_input), as with the AFL++ bridge.
+ */
+
+#ifndef _HF_INPUT_H_
+#define _HF_INPUT_H_
+
+#include "honggfuzz.h"
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+
+extern uint8_t* queue_input;
+extern size_t   queue_input_size;
+
+static inline void input_setSize(run_t* run, size_t sz) {
+    if (sz > run->global->mutate.maxInputSz) {
+        LOG_F("Too large size requested: %zu > maxSize: %zu", sz, run->global->mutate.maxInputSz);
+    }
+    run->dynfile->size = sz;
+}
+
+static inline const uint8_t* input_getRandomInputAsBuf(run_t* run HF_ATTR_UNUSED, size_t* len) {
+    *len = queue_input_size;
+    return queue_input;
+}
+
+#endif /* _HF_INPUT_H_ */
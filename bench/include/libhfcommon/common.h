@@ -0,0 +1,33 @@
+/*
+ * Honggfuzz+ - minimal stand-in for libhfcommon/common.h, for the mangle benchmark
+ */
+
+#ifndef _HF_COMMON_H_
+#define _HF_COMMON_H_
+
+#include <stdlib.h>
+
+#define ARRAYSIZE(array) (sizeof(array) / sizeof(*array))
+
+#define HF_MIN(x, y) (x <= y ? x : y)
+#define HF_MAX(x, y) (x >= y ? x : y)
+
+#define HF_ATTR_UNUSED __attribute__((unused))
+
+#define ATOMIC_GET(x)    __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define ATOMIC_SET(x, y) __atomic_store_n(&(x), y, __ATOMIC_RELAXED)
+
+#define wmb() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define rmb() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/* defer {} is implemented with GCC nested functions, as in libhfcommon */
+#define __STRMERGE(a, b) a##b
+#define _STRMERGE(a, b)  __STRMERGE(a, b)
+#define _DEFER(a, count)                                                                           \
+    auto void _STRMERGE(__defer_f_, count)(void* _defer_arg __attribute__((unused)));             \
+    int       _STRMERGE(__defer_var_, count) __attribute__((cleanup(_STRMERGE(__defer_f_, count)))) \
+        __attribute__((unused));                                                                   \
+    void _STRMERGE(__defer_f_, count)(void* _defer_arg __attribute__((unused)))
+#define defer _DEFER(a, __COUNTER__)
+
+#endif /* _HF_COMMON_H_ */
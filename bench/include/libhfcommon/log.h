@@ -0,0 +1,32 @@
+/*
+ * Honggfuzz+ - minimal stand-in for libhfcommon/log.h, for the mangle benchmark
+ */
+
+#ifndef _HF_LOG_H_
+#define _HF_LOG_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LOG_HELPER(lvl, ...)                                                                       \
+    do {                                                                                           \
+        fprintf(stderr, "[" lvl "] " __VA_ARGS__);                                                 \
+        fprintf(stderr, "\n");                                                                     \
+    } while (0)
+
+#define LOG_D(...)                                                                                 \
+    do {                                                                                           \
+    } while (0)
+#define LOG_I(...)  LOG_HELPER("I", __VA_ARGS__)
+#define LOG_W(...)  LOG_HELPER("W", __VA_ARGS__)
+#define LOG_E(...)  LOG_HELPER("E", __VA_ARGS__)
+#define PLOG_W(...) LOG_HELPER("W", __VA_ARGS__)
+#define PLOG_E(...) LOG_HELPER("E", __VA_ARGS__)
+#define LOG_F(...)                                                                                 \
+    do {                                                                                           \
+        LOG_HELPER("F", __VA_ARGS__);                                                              \
+        abort();                                                                                   \
+    } while (0)
+#define PLOG_F(...) LOG_F(__VA_ARGS__)
+
+#endif /* _HF_LOG_H_ */
@@ -0,0 +1,87 @@
+/*
+ * Honggfuzz+ - minimal stand-in for libhfcommon/util.h, for the mangle benchmark
+ * -----------------------------------------
+ *
+ * Same generator (xoroshiro128+) and helpers as libhfcommon, but seeded with util_rndSeed() so
+ * that benchmark runs are reproducible. The generator and the buffer fills are kept out of line,
+ * as they are in libhfcommon/util.c.
+ */
+
+#ifndef _HF_UTIL_H_
+#define _HF_UTIL_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "log.h"
+
+static __thread uint64_t util_rndState[2] = {0x9E3779B97F4A7C15ULL, 0xD1B54A32D192ED03ULL};
+
+static inline void util_rndSeed(uint64_t seed) {
+    util_rndState[0] = seed ^ 0x9E3779B97F4A7C15ULL;
+    util_rndState[1] = (seed * 0xBF58476D1CE4E5B9ULL) ^ 0xD1B54A32D192ED03ULL;
+}
+
+static inline uint64_t util_RotL(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+__attribute__((noinline)) static uint64_t util_rnd64(void) {
+    const uint64_t s0     = util_rndState[0];
+    uint64_t       s1     = util_rndState[1];
+    const uint64_t result = s0 + s1;
+    s1 ^= s0;
+    util_rndState[0] = util_RotL(s0, 55) ^ s1 ^ (s1 << 14);
+    util_rndState[1] = util_RotL(s1, 36);
+    return result;
+}
+
+__attribute__((noinline)) static uint64_t util_rndGet(uint64_t min, uint64_t max) {
+    if (min > max) {
+        LOG_F("min:%llu > max:%llu", (unsigned long long)min, (unsigned long long)max);
+    }
+    if (max == UINT64_MAX) {
+        return util_rnd64();
+    }
+    return ((util_rnd64() % (max - min + 1)) + min);
+}
+
+static inline uint8_t util_rndPrintable(void) {
+    return (uint8_t)util_rndGet(32, 126);
+}
+
+__attribute__((noinline)) static void util_rndBuf(uint8_t* buf, size_t sz) {
+    for (size_t i = 0; i < sz; i++) {
+        buf[i] = (uint8_t)util_rnd64();
+    }
+}
+
+__attribute__((noinline)) static void util_rndBufPrintable(uint8_t* buf, size_t sz) {
+    for (size_t i = 0; i < sz; i++) {
+        buf[i] = util_rndPrintable();
+    }
+}
+
+static inline void util_turnToPrintable(uint8_t* buf, size_t sz) {
+    for (size_t i = 0; i < sz; i++) {
+        buf[i] = buf[i] % 95 + 32;
+    }
+}
+
+static inline void* util_Malloc(size_t sz) {
+    void* p = malloc(sz);
+    if (p == NULL) {
+        LOG_F("malloc(size='%zu')", sz);
+    }
+    return p;
+}
+
+static inline void* util_Calloc(size_t sz) {
+    void* p = util_Malloc(sz);
+    memset(p, '\0', sz);
+    return p;
+}
+
+#endif /* _HF_UTIL_H_ */
@@ -0,0 +1,447 @@
+/*
+ * Honggfuzz+ - micro-benchmark for the mangle operators
+ * -----------------------------------------
+ *
+ * Runs every operator in mangleFuncs (each mangle_MemSwap variant separately), and whole
+ * mangle_mangleContent() rounds, over inputs from 16 bytes to _HF_INPUT_MAX_SIZE, and reports
+ * ns/op, input bytes/s and heap allocations per op. mangle.c is included directly, so that the
+ * static operators can be called one by one; honggfuzz and AFL++ are replaced by the stand-ins
+ * in bench/include.
+ *
+ * Every measurement reseeds the PRNG from the seed (-S), the operator and the size, so results
+ * don't depend on which other measurements were selected. Rounds use the uniform pick by default,
+ * as the adaptive scheduler weights operators by wall time; use -a to benchmark it anyway.
+ *
+ * With -c, the rounds are checked instead: inline ones, those of mangle_mangleBatch(), and the
+ * pipeline slots (mutpipe.h). The output of a round is turned back into the seed by copying only
+ * the ranges it changed, and written over the previous output as afl_custom_fuzz_send() does it
+ * with HF_DIRTY_WRITE, which must leave the same bytes as writing all of it. A mismatch aborts.
+ *
+ * Usage: mangle_bench [-o operator] [-v memswap_variant] [-s size] [-i iterations] [-S seed]
+ *                     [-a] [-p] [-c]
+ */
+
+#include "../mangle.c"
+#include "../mutpipe.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <sched.h>
+
+uint8_t* queue_input;
+size_t   queue_input_size;
+
+/*
+ * Heap allocations are counted by interposing the glibc allocator, other libcs don't export the
+ * __libc_* entry points, and report -1
+ */
+static uint64_t benchAllocs = 0;
+
+#if defined(__GLIBC__)
+extern void* __libc_malloc(size_t sz);
+extern void* __libc_calloc(size_t n, size_t sz);
+extern void* __libc_realloc(void* ptr, size_t sz);
+extern void* __libc_memalign(size_t align, size_t sz);
+
+void* malloc(size_t sz) {
+    benchAllocs++;
+    return __libc_malloc(sz);
+}
+
+void* calloc(size_t n, size_t sz) {
+    benchAllocs++;
+    return __libc_calloc(n, sz);
+}
+
+void* realloc(void* ptr, size_t sz) {
+    benchAllocs++;
+    return __libc_realloc(ptr, sz);
+}
+
+int posix_memalign(void** ptr, size_t align, size_t sz) {
+    benchAllocs++;
+    *ptr = __libc_memalign(align, sz);
+    return (*ptr == NULL) ? ENOMEM : 0;
+}
+#define BENCH_ALLOCS_COUNTED true
+#else
+#define BENCH_ALLOCS_COUNTED false
+#endif /* defined(__GLIBC__) */
+
+static const size_t benchSizes[] = {
+    16, 64, 256, 1024, 4096, 16384, 65536, 262144, _HF_INPUT_MAX_SIZE,
+};
+
+/* Enough iterations to process ~64 MiB of input, within [64, 200000] */
+#define BENCH_BYTES_PER_TEST (64ULL * 1024ULL * 1024ULL)
+#define BENCH_MIN_ITERS      64ULL
+#define BENCH_MAX_ITERS      200000ULL
+
+static struct {
+    const char* op;
+    const char* variant;
+    size_t      size;
+    uint64_t    iters;
+    uint64_t    seed;
+    bool        adaptive;
+    bool        printable;
+    bool        check;
+} benchCfg = {
+    .seed = 0x686F6E67677A7A21ULL,
+};
+
+static honggfuzz_t benchGlobal;
+static dynfile_t   benchDynfile;
+static run_t       benchRun;
+static uint8_t*    benchSeedData;
+
+static uint64_t bench_nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_iters(size_t size) {
+    if (benchCfg.iters) {
+        return benchCfg.iters;
+    }
+    uint64_t iters = BENCH_BYTES_PER_TEST / size;
+    return HF_MIN(HF_MAX(iters, BENCH_MIN_ITERS), BENCH_MAX_ITERS);
+}
+
+/* Input and corpus (used by Splice) start from the same seeded random buffer */
+static void bench_reset(uint64_t salt, size_t size) {
+    uint64_t seed = benchCfg.seed ^ (salt * 0x9E3779B97F4A7C15ULL) ^ size;
+    util_rndSeed(seed);
+    fastrnd_seed(seed);
+    if (benchCfg.printable) {
+        util_rndBufPrintable(benchSeedData, size);
+    } else {
+        util_rndBuf(benchSeedData, size);
+    }
+    memcpy(benchDynfile.data, benchSeedData, size);
+    benchDynfile.size = size;
+    queue_input       = benchSeedData;
+    queue_input_size  = size;
+}
+
+static void bench_report(const char* name, const char* variant, size_t size, uint64_t iters,
+    uint64_t ns, uint64_t allocs) {
+    double nsPerOp  = (double)ns / iters;
+    double mbPerSec = nsPerOp > 0.0 ? ((double)size / nsPerOp) * 1e9 / (1024.0 * 1024.0) : 0.0;
+    printf("%-18s %-9s %8zu %9" PRIu64 " %12.1f %11.1f %10.3f\n", name, variant, size, iters,
+        nsPerOp, mbPerSec, BENCH_ALLOCS_COUNTED ? (double)allocs / iters : -1.0);
+    fflush(stdout);
+}
+
+/*
+ * The input size is restored before each call, but not its content, so that the cost of
+ * resetting 1 MiB inputs doesn't hide the cost of the operator. Each call is a round of its own,
+ * so it includes flattening the piece table, and folding the bytes it wrote with -p.
+ */
+static void bench_func(const char* name, const char* variant, size_t op,
+    void (*func)(run_t* run, bool printable), size_t size) {
+    uint64_t iters = bench_iters(size);
+    bench_reset(op, size);
+    mangleLenDist = mangleLenDists[op].len;
+    mangleOffDist = mangleLenDists[op].off;
+
+    uint64_t allocs = benchAllocs;
+    uint64_t start  = bench_nowNs();
+    for (uint64_t i = 0; i < iters; i++) {
+        benchDynfile.size = size;
+        mangle_editBegin(&benchRun);
+        func(&benchRun, benchCfg.printable);
+        mangle_editFold();
+        mangle_editFlatten();
+    }
+    uint64_t ns = bench_nowNs() - start;
+    bench_report(name, variant, size, iters, ns, benchAllocs - allocs);
+}
+
+static void bench_rounds(const char* variant, size_t size) {
+    uint64_t iters = bench_iters(size);
+    bench_reset(MANGLE_FUNCS_CNT, size);
+    mangleSchedAdaptive = benchCfg.adaptive;
+    mangleSched.cnt     = 0;
+
+    uint64_t allocs = benchAllocs;
+    uint64_t start  = bench_nowNs();
+    for (uint64_t i = 0; i < iters; i++) {
+        benchDynfile.size = size;
+        mangle_mangleContent(&benchRun, /* speed_factor= */ 1);
+    }
+    uint64_t ns = bench_nowNs() - start;
+    bench_report("Round", variant, size, iters, ns, benchAllocs - allocs);
+}
+
+/*
+ * The testcase of the checks, written as afl_custom_fuzz_send() writes it: when it holds an output
+ * of the same seed, only the ranges which either output changed, and all from the first moved byte
+ */
+static struct {
+    uint8_t*   data;
+    bool       partial; /* holds an output which changed 'changed' */
+    dirtyset_t changed;
+    size_t     movedFrom;
+} benchTestcase;
+
+/* Writes 'out' to the testcase, partially if its changes are known, and checks it */
+static void bench_send(const char* mode, uint64_t iter, const uint8_t* out, size_t size,
+    const dirtyset_t* changed, size_t movedFrom) {
+    if (changed && benchTestcase.partial) {
+        dirtyset_t both = *changed;
+        for (size_t i = 0; i < benchTestcase.changed.cnt; i++) {
+            dirtyset_mark(&both, benchTestcase.changed.ranges[i].lo,
+                benchTestcase.changed.ranges[i].hi - benchTestcase.changed.ranges[i].lo);
+        }
+        size_t from = HF_MIN(movedFrom, benchTestcase.movedFrom);
+        from        = HF_MIN(from, size);
+        for (size_t i = 0; i < both.cnt && both.ranges[i].lo < from; i++) {
+            size_t lo = both.ranges[i].lo;
+            memcpy(&benchTestcase.data[lo], &out[lo], HF_MIN(both.ranges[i].hi, from) - lo);
+        }
+        memcpy(&benchTestcase.data[from], &out[from], size - from);
+    } else {
+        memcpy(benchTestcase.data, out, size);
+    }
+    if (memcmp(benchTestcase.data, out, size) != 0) {
+        LOG_F("%s: a partial write differs from the output, size:%zu iteration:%" PRIu64, mode,
+            size, iter);
+    }
+    benchTestcase.partial = changed != NULL;
+    if (changed) {
+        benchTestcase.changed   = *changed;
+        benchTestcase.movedFrom = movedFrom;
+    }
+}
+
+/* Turns a copy of an output of the seed back into it, from the ranges it changed */
+static void bench_restore(const char* mode, uint64_t iter, const uint8_t* out, size_t outSize,
+    const dirtyset_t* changed, size_t movedFrom) {
+    size_t   size = benchDynfile.size;
+    uint8_t* tmp  = benchTestcase.data + _HF_INPUT_MAX_SIZE;
+    memcpy(tmp, out, HF_MAX(size, outSize));
+    mangle_restoreChanges(tmp, benchSeedData, size, changed, movedFrom);
+    if (memcmp(tmp, benchSeedData, size) != 0) {
+        LOG_F("%s: the restored output differs from the seed, size:%zu iteration:%" PRIu64, mode,
+            size, iter);
+    }
+}
+
+/* Rounds of mangle_mangleContent(), each made from the previous output, restored in place */
+static void bench_checkInline(const char* variant, size_t size) {
+    uint64_t iters = bench_iters(size);
+    bench_reset(MANGLE_FUNCS_CNT, size);
+    benchTestcase.partial = false;
+
+    uint64_t allocs = benchAllocs;
+    uint64_t start  = bench_nowNs();
+    for (uint64_t i = 0; i < iters; i++) {
+        mangle_mangleContent(&benchRun, /* speed_factor= */ 1);
+        dirtyset_t changed;
+        size_t     movedFrom;
+        mangle_lastRoundChanges(&changed, &movedFrom);
+        bench_send("Check/inline", i, benchDynfile.data, benchDynfile.size, &changed, movedFrom);
+        mangle_restoreSeed(benchDynfile.data, benchSeedData, size);
+        benchDynfile.size = size;
+        if (memcmp(benchDynfile.data, benchSeedData, size) != 0) {
+            LOG_F("Check/inline: the restored output differs from the seed, size:%zu "
+                  "iteration:%" PRIu64,
+                size, i);
+        }
+    }
+    uint64_t ns = bench_nowNs() - start;
+    bench_report("Check/inline", variant, size, iters, ns, benchAllocs - allocs);
+}
+
+#define BENCH_CHECK_LANES 16U
+
+/*
+ * The seed is left as it was, the mutants stay in their slots, and the last one, which the changes
+ * of the last round refer to, is restored, and written over the last one of the previous batch
+ */
+static void bench_checkBatch(const char* variant, size_t size) {
+    static uint8_t* out = NULL;
+    size_t          cap = 4 * _HF_INPUT_MAX_SIZE;
+    if (!out) {
+        out = util_Malloc(cap);
+    }
+    uint64_t iters = bench_iters(size);
+    bench_reset(MANGLE_FUNCS_CNT, size);
+    benchTestcase.partial = false;
+
+    uint64_t allocs = benchAllocs;
+    uint64_t start  = bench_nowNs();
+    for (uint64_t i = 0; i < iters;) {
+        size_t offs[BENCH_CHECK_LANES], sizes[BENCH_CHECK_LANES];
+        size_t made = mangle_mangleBatch(
+            &benchRun, /* speed_factor= */ 1, out, cap, offs, sizes, BENCH_CHECK_LANES);
+        if (made == 0 || benchDynfile.size != size ||
+            memcmp(benchDynfile.data, benchSeedData, size) != 0) {
+            LOG_F("Check/batch: the seed was changed, size:%zu iteration:%" PRIu64, size, i);
+        }
+        for (size_t l = 0; l < made && i < iters; l++, i++) {
+            if (l + 1 < made && offs[l] + sizes[l] > offs[l + 1]) {
+                LOG_F("Check/batch: mutant %zu overlaps the next one, size:%zu iteration:%" PRIu64,
+                    l, size, i);
+            }
+            mangle_runBatchMutant(l);
+            if (l + 1 < made) {
+                continue;
+            }
+            dirtyset_t changed;
+            size_t     movedFrom;
+            mangle_lastRoundChanges(&changed, &movedFrom);
+            bench_send("Check/batch", i, &out[offs[l]], sizes[l], &changed, movedFrom);
+            bench_restore("Check/batch", i, &out[offs[l]], sizes[l], &changed, movedFrom);
+        }
+    }
+    uint64_t ns = bench_nowNs() - start;
+    bench_report("Check/batch", variant, size, iters, ns, benchAllocs - allocs);
+}
+
+/* Mutants of two workers, each made in a slot which held an older one, restored from its changes */
+static void bench_checkPipeline(const char* variant, size_t size) {
+    uint64_t iters = bench_iters(size);
+    bench_reset(MANGLE_FUNCS_CNT, size);
+    benchTestcase.partial = false;
+
+    mutpipe_t pipe;
+    mutpipe_init(&pipe, 2, &benchGlobal, _HF_INPUT_MAX_SIZE);
+    mutpipe_setSeed(&pipe, benchSeedData, size, /* speedFactor= */ 1);
+
+    uint64_t allocs = benchAllocs;
+    uint64_t start  = bench_nowNs();
+    for (uint64_t i = 0; i < iters;) {
+        const mutpipe_slot_t* slot = mutpipe_pop(&pipe);
+        if (!slot) {
+            sched_yield();
+            continue;
+        }
+        bench_send("Check/pipe", i, slot->data, slot->size, &slot->changed, slot->movedFrom);
+        bench_restore("Check/pipe", i, slot->data, slot->size, &slot->changed, slot->movedFrom);
+        i++;
+    }
+    uint64_t ns = bench_nowNs() - start;
+    mutpipe_destroy(&pipe);
+    bench_report("Check/pipe", variant, size, iters, ns, benchAllocs - allocs);
+}
+
+static bool bench_selected(const char* filter, const char* name) {
+    return filter == NULL || strcasecmp(filter, name) == 0;
+}
+
+static void bench_usage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s [-o operator] [-v memswap_variant] [-s size] [-i iterations] [-S seed] [-a] "
+        "[-p] [-c]\n"
+        "  -o  only this operator (e.g. MemSwap, AESBlocks), or 'Round' for mangle_mangleContent\n"
+        "  -v  only this mangle_MemSwap variant: baseline, sp or fl\n"
+        "  -s  only this input size, in bytes (1..%llu)\n"
+        "  -i  iterations per test (default: enough for ~64 MiB of input)\n"
+        "  -S  PRNG seed\n"
+        "  -a  use the adaptive scheduler in rounds (default: uniform, reproducible)\n"
+        "  -p  printable inputs and mutations\n"
+        "  -c  check that the outputs of inline, batch and pipeline rounds restore to the seed, and\n"
+        "      that writing only their changes leaves the same testcase as writing all of them\n",
+        argv0, (unsigned long long)_HF_INPUT_MAX_SIZE);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+    for (int c; (c = getopt(argc, argv, "o:v:s:i:S:apch")) != -1;) {
+        switch (c) {
+        case 'o':
+            benchCfg.op = optarg;
+            break;
+        case 'v':
+            benchCfg.variant = optarg;
+            break;
+        case 's':
+            benchCfg.size = strtoull(optarg, NULL, 0);
+            if (benchCfg.size == 0 || benchCfg.size > _HF_INPUT_MAX_SIZE) {
+                bench_usage(argv[0]);
+            }
+            break;
+        case 'i':
+            benchCfg.iters = strtoull(optarg, NULL, 0);
+            break;
+        case 'S':
+            benchCfg.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'a':
+            benchCfg.adaptive = true;
+            break;
+        case 'p':
+            benchCfg.printable = true;
+            break;
+        case 'c':
+            benchCfg.check = true;
+            break;
+        default:
+            bench_usage(argv[0]);
+        }
+    }
+
+    benchGlobal.mutate.maxInputSz      = _HF_INPUT_MAX_SIZE;
+    benchGlobal.mutate.mutationsPerRun = 5;
+    benchGlobal.timing.lastCovUpdate   = 6;
+    benchGlobal.cfg.only_printable     = benchCfg.printable;
+    benchRun.global                    = &benchGlobal;
+    benchRun.dynfile                   = &benchDynfile;
+    benchRun.mutationsPerRun           = 5;
+    benchDynfile.data                  = util_Malloc(_HF_INPUT_MAX_SIZE);
+    benchSeedData                      = util_Malloc(_HF_INPUT_MAX_SIZE);
+    benchTestcase.data                 = util_Malloc(2 * _HF_INPUT_MAX_SIZE);
+
+    printf("# %-16s %-9s %8s %9s %12s %11s %10s\n", "operator", "variant", "size", "iters",
+        "ns/op", "MiB/s", "allocs/op");
+
+    for (size_t s = 0; s < ARRAYSIZE(benchSizes); s++) {
+        size_t size = benchCfg.size ? benchCfg.size : benchSizes[s];
+
+        for (size_t v = 0; benchCfg.check && v < ARRAYSIZE(mangleMemSwapVariants); v++) {
+            if (!bench_selected(benchCfg.variant, mangleMemSwapVariants[v].name)) {
+                continue;
+            }
+            mangleFuncs[MANGLE_MEM_SWAP] = mangleMemSwapVariants[v].func;
+            mangleSchedAdaptive          = benchCfg.adaptive;
+            bench_checkInline(mangleMemSwapVariants[v].name, size);
+            bench_checkBatch(mangleMemSwapVariants[v].name, size);
+            bench_checkPipeline(mangleMemSwapVariants[v].name, size);
+        }
+
+        for (size_t f = 0; !benchCfg.check && f < MANGLE_FUNCS_CNT; f++) {
+            if (!bench_selected(benchCfg.op, mangleFuncNames[f])) {
+                continue;
+            }
+            if (f != MANGLE_MEM_SWAP) {
+                bench_func(mangleFuncNames[f], "-", f, mangleFuncs[f], size);
+                continue;
+            }
+            for (size_t v = 0; v < ARRAYSIZE(mangleMemSwapVariants); v++) {
+                if (bench_selected(benchCfg.variant, mangleMemSwapVariants[v].name)) {
+                    bench_func(mangleFuncNames[f], mangleMemSwapVariants[v].name, f,
+                        mangleMemSwapVariants[v].func, size);
+                }
+            }
+        }
+
+        if (!benchCfg.check && bench_selected(benchCfg.op, "Round")) {
+            for (size_t v = 0; v < ARRAYSIZE(mangleMemSwapVariants); v++) {
+                if (!bench_selected(benchCfg.variant, mangleMemSwapVariants[v].name)) {
+                    continue;
+                }
+                mangleFuncs[MANGLE_MEM_SWAP] = mangleMemSwapVariants[v].func;
+                bench_rounds(mangleMemSwapVariants[v].name, size);
+            }
+        }
+
+        if (benchCfg.size) {
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+/*
+ * Honggfuzz+ - per-thread cache of the comparison feedback dictionary
+ * -----------------------------------------
+ *
+ * The cmpfeedback_t map is shared with the instrumented target, which appends the operands of
+ * comparisons to it: a writer takes a slot by incrementing cnt, copies the value, and publishes it
+ * by setting its len. Slots are written once, so len works as the sequence number of a seqlock
+ * with a single write: a reader loads it with acquire semantics, copies the value, and keeps the
+ * copy only if len is the same afterwards. A slot taken but not published yet ends the scan, and is
+ * skipped if it stays that way for CMPCACHE_STALL_ROUNDS rounds (e.g. its writer was killed). If
+ * cnt goes backwards, or the map changes, the map was reset, and so is the cache.
+ *
+ * cmpcache_refresh() copies the newly published values once per round, so that picking one only
+ * touches memory of the thread. The map doesn't record how often an operand was compared (the
+ * writers drop repeated values), so each cached value is weighted by 1 + the number of new corpus
+ * entries produced by rounds which used it. Weights are kept in a Fenwick tree: adding a value,
+ * crediting one and picking one with a single random draw cost O(log n).
+ */
+
+#ifndef _HF_CMPCACHE_H_
+#define _HF_CMPCACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "honggfuzz.h"
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+
+#define CMPCACHE_MIN_CAP 256U
+/* Rounds after which a slot taken but not published is skipped */
+#define CMPCACHE_STALL_ROUNDS 256U
+/* Values of a round which are credited when it produces a new corpus entry */
+#define CMPCACHE_MAX_USED 32U
+
+typedef struct {
+    uint8_t  val[sizeof(((cmpfeedback_t*)0)->valArr[0].val)];
+    uint32_t len;
+    uint32_t weight;
+} cmpcache_ent_t;
+
+typedef struct {
+    const cmpfeedback_t* map;
+    uint32_t             seen; /* slots [0, seen) of the map were scanned */
+    uint32_t             stalled;
+    cmpcache_ent_t*      ents;
+    uint32_t*            tree; /* Fenwick tree of the weights, 1-based */
+    uint32_t             cnt;
+    uint32_t             cap; /* power of 2 */
+    uint64_t             total;
+    uint32_t             used[CMPCACHE_MAX_USED];
+    uint32_t             usedCnt;
+} cmpcache_t;
+
+static inline void cmpcache_add(cmpcache_t* c, uint32_t i, uint32_t delta) {
+    for (uint32_t j = i + 1; j <= c->cap; j += j & -j) {
+        c->tree[j] += delta;
+    }
+    c->ents[i].weight += delta;
+    c->total += delta;
+}
+
+/* Only the slot of a new value is missing, the tree is rebuilt from the weights */
+__attribute__((noinline, cold)) static void cmpcache_grow(cmpcache_t* c) {
+    uint32_t cap = c->cap ? c->cap * 2 : CMPCACHE_MIN_CAP;
+    c->ents      = realloc(c->ents, cap * sizeof(c->ents[0]));
+    c->tree      = realloc(c->tree, (cap + 1) * sizeof(c->tree[0]));
+    if (c->ents == NULL || c->tree == NULL) {
+        LOG_F("realloc(nmemb='%" PRIu32 "') failed", cap);
+    }
+    c->cap = cap;
+    memset(c->tree, 0, (cap + 1) * sizeof(c->tree[0]));
+    for (uint32_t j = 1; j <= c->cnt; j++) {
+        c->tree[j] += c->ents[j - 1].weight;
+        uint32_t parent = j + (j & -j);
+        if (parent <= cap) {
+            c->tree[parent] += c->tree[j];
+        }
+    }
+}
+
+static inline void cmpcache_reset(cmpcache_t* c, const cmpfeedback_t* map) {
+    c->map     = map;
+    c->seen    = 0;
+    c->stalled = 0;
+    c->cnt     = 0;
+    c->total   = 0;
+    c->usedCnt = 0;
+    if (c->tree) {
+        memset(c->tree, 0, (c->cap + 1) * sizeof(c->tree[0]));
+    }
+}
+
+/* Copies the values published in 'map' since the last call, at the start of a round */
+static inline void cmpcache_refresh(cmpcache_t* c, const cmpfeedback_t* map) {
+    c->usedCnt = 0;
+    uint32_t n = __atomic_load_n(&map->cnt, __ATOMIC_ACQUIRE);
+    if (__builtin_expect(map != c->map || n < c->seen, 0)) {
+        cmpcache_reset(c, map);
+    }
+    n = HF_MIN(n, (uint32_t)ARRAYSIZE(map->valArr));
+
+    while (c->seen < n) {
+        const uint8_t* val = map->valArr[c->seen].val;
+        uint32_t       len = __atomic_load_n(&map->valArr[c->seen].len, __ATOMIC_ACQUIRE);
+        if (len == 0 || len > sizeof(c->ents[0].val)) {
+            /* Not published yet */
+            if (++c->stalled < CMPCACHE_STALL_ROUNDS) {
+                return;
+            }
+            c->stalled = 0;
+            c->seen++;
+            continue;
+        }
+        if (c->cnt == c->cap) {
+            cmpcache_grow(c);
+        }
+        cmpcache_ent_t* e = &c->ents[c->cnt];
+        memcpy(e->val, val, len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&map->valArr[c->seen].len, __ATOMIC_RELAXED) != len) {
+            /* Rewritten while copied, try again next round */
+            return;
+        }
+        e->len    = len;
+        e->weight = 0;
+        cmpcache_add(c, c->cnt++, 1);
+        c->stalled = 0;
+        c->seen++;
+    }
+}
+
+/* Picks a value with a probability proportional to its weight, NULL if there are none */
+static inline const uint8_t* cmpcache_pick(cmpcache_t* c, uint64_t rnd, size_t* len) {
+    if (c->total == 0) {
+        return NULL;
+    }
+    uint64_t r   = (uint64_t)(((unsigned __int128)rnd * c->total) >> 64);
+    uint32_t pos = 0;
+    for (uint32_t step = c->cap; step; step >>= 1) {
+        if ((pos + step) <= c->cap && c->tree[pos + step] <= r) {
+            pos += step;
+            r -= c->tree[pos];
+        }
+    }
+    if (c->usedCnt < CMPCACHE_MAX_USED) {
+        c->used[c->usedCnt++] = pos;
+    }
+    *len = c->ents[pos].len;
+    return c->ents[pos].val;
+}
+
+/* The last round produced a new corpus entry, credit the values which it used */
+static inline void cmpcache_credit(cmpcache_t* c) {
+    for (uint32_t i = 0; i < c->usedCnt; i++) {
+        if (c->used[i] < c->cnt) {
+            cmpcache_add(c, c->used[i], 1);
+        }
+    }
+    c->usedCnt = 0;
+}
+
+/* Takes the values used by the current round out, into 'used', returns their count */
+static inline uint32_t cmpcache_saveRound(cmpcache_t* c, uint32_t* used) {
+    uint32_t cnt = c->usedCnt;
+    memcpy(used, c->used, cnt * sizeof(c->used[0]));
+    c->usedCnt = 0;
+    return cnt;
+}
+
+/* Values saved by cmpcache_saveRound() are those of the current round again */
+static inline void cmpcache_runRound(cmpcache_t* c, const uint32_t* used, uint32_t cnt) {
+    memcpy(c->used, used, cnt * sizeof(c->used[0]));
+    c->usedCnt = cnt;
+}
+
+#endif /* _HF_CMPCACHE_H_ */
@@ -0,0 +1,291 @@
+/*
+ * Honggfuzz+ - index of the corpus by content, for mangle_Splice
+ * -----------------------------------------
+ *
+ * Inputs are copied into the index as they're added to the corpus, and cut into content-defined
+ * chunks with a gear rolling hash: h = (h << 1) + gear[byte] depends on the last CORPIDX_WINDOW
+ * bytes only, and a chunk ends where its top CORPIDX_CHUNK_BITS bits are 0, i.e. every 64 bytes on
+ * average. Boundaries depend on the content alone, so the same bytes have the same boundaries in
+ * any input, wherever they are, and the hash at a boundary is a fingerprint of the bytes before it.
+ *
+ * Fingerprints are kept in an open-addressing table (linear probing, at most half full), with the
+ * input and the offset of the boundary, and at most CORPIDX_MAX_DUPS inputs per fingerprint.
+ * mangle_Splice rolls the hash over a part of the input being mutated, and looks each boundary up
+ * in O(1): a hit is a place where both inputs have the same content, from which the input can be
+ * spliced with the other one where they start to differ (like AFL's locate_diffs()).
+ *
+ * The inputs held by the index are a ring within a memory budget: the oldest ones are evicted to
+ * make room for new ones. Their slots stay in the table, as an emptied slot would cut the probe
+ * chains through it, but are skipped by lookups and reused by insertions, and dropped when the
+ * table is rebuilt.
+ *
+ * The index is shared by all threads, and isn't locked: the caller serializes corpidx_insert() with
+ * the lookups. Cutting an input (corpidx_cut()) only reads the gear table, and can run
+ * concurrently.
+ */
+
+#ifndef _HF_CORPIDX_H_
+#define _HF_CORPIDX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+
+/* Bytes which the hash at a boundary depends on */
+#define CORPIDX_WINDOW 64U
+/* A position is a boundary with a probability of 2^-CORPIDX_CHUNK_BITS */
+#define CORPIDX_CHUNK_BITS 6U
+/* Inputs kept per fingerprint, newer ones replace older ones */
+#define CORPIDX_MAX_DUPS 4U
+/* Default budget of the input bytes held by the index */
+#define CORPIDX_DEFAULT_BUDGET (256ULL * 1024ULL * 1024ULL)
+#define CORPIDX_MIN_BITS       10U
+
+typedef struct {
+    uint64_t fp; /* 0: empty */
+    uint32_t input;
+    uint32_t off; /* of the first byte after the boundary */
+} corpidx_slot_t;
+
+typedef struct {
+    uint8_t* data; /* NULL: evicted */
+    size_t   len;
+    size_t   slots;
+} corpidx_input_t;
+
+/* A boundary of an input, from corpidx_cut() */
+typedef struct {
+    uint64_t fp;
+    uint32_t off;
+} corpidx_cut_t;
+
+/* A place in an indexed input where the content looked up ends */
+typedef struct {
+    const uint8_t* data;
+    size_t         len;
+    size_t         off;
+} corpidx_hit_t;
+
+typedef struct {
+    uint64_t         gear[256];
+    corpidx_slot_t*  slots;
+    size_t           bits; /* slots: 2^bits */
+    size_t           used;
+    size_t           stale; /* used slots of evicted inputs */
+    corpidx_input_t* inputs; /* by id, [first, cnt) are held */
+    size_t           first;
+    size_t           cnt;
+    size_t           cap;
+    size_t           bytes;
+    size_t           budget;
+} corpidx_t;
+
+static inline uint64_t corpidx_roll(const corpidx_t* x, uint64_t h, uint8_t c) {
+    return (h << 1) + x->gear[c];
+}
+
+static inline bool corpidx_isBoundary(uint64_t h) {
+    return (h >> (64 - CORPIDX_CHUNK_BITS)) == 0;
+}
+
+/* The low bits of the hash depend on the last few bytes only, the fingerprint mixes all of them */
+static inline uint64_t corpidx_fp(uint64_t h) {
+    h ^= h >> 31;
+    h *= 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    return h | 1;
+}
+
+static inline size_t corpidx_slotOf(const corpidx_t* x, uint64_t fp) {
+    return (size_t)((fp * 0xD6E8FEB86659FD93ULL) >> (64 - x->bits));
+}
+
+static inline bool corpidx_isHeld(const corpidx_t* x, uint32_t input) {
+    return input >= x->first;
+}
+
+static inline void corpidx_put(corpidx_t* x, uint64_t fp, uint32_t input, uint32_t off) {
+    size_t mask  = ((size_t)1 << x->bits) - 1;
+    size_t reuse = SIZE_MAX;
+    size_t dups[CORPIDX_MAX_DUPS];
+    size_t dupCnt = 0;
+    size_t i;
+    for (i = corpidx_slotOf(x, fp); x->slots[i].fp; i = (i + 1) & mask) {
+        if (!corpidx_isHeld(x, x->slots[i].input)) {
+            reuse = (reuse == SIZE_MAX) ? i : reuse;
+            continue;
+        }
+        if (x->slots[i].fp != fp) {
+            continue;
+        }
+        if (x->slots[i].input == input) {
+            /* Repeated content within an input, its first place is enough */
+            return;
+        }
+        dups[dupCnt++] = i;
+        if (dupCnt == CORPIDX_MAX_DUPS) {
+            i = dups[input % CORPIDX_MAX_DUPS];
+            x->inputs[x->slots[i].input].slots--;
+            x->inputs[input].slots++;
+            x->slots[i].input = input;
+            x->slots[i].off   = off;
+            return;
+        }
+    }
+    if (reuse != SIZE_MAX) {
+        i = reuse;
+        x->stale--;
+    } else {
+        x->used++;
+    }
+    x->slots[i] = (corpidx_slot_t){.fp = fp, .input = input, .off = off};
+    x->inputs[input].slots++;
+}
+
+/* Rebuilds the table without the slots of evicted inputs, twice as large if half of it is held */
+__attribute__((noinline, cold)) static void corpidx_rebuild(corpidx_t* x) {
+    corpidx_slot_t* old     = x->slots;
+    size_t          oldSize = x->slots ? ((size_t)1 << x->bits) : 0;
+    if (x->slots == NULL) {
+        x->bits = CORPIDX_MIN_BITS;
+    } else if ((x->used - x->stale) * 4 > oldSize) {
+        x->bits++;
+    }
+    x->slots = calloc((size_t)1 << x->bits, sizeof(x->slots[0]));
+    if (x->slots == NULL) {
+        LOG_F("calloc(nmemb=%zu) failed", (size_t)1 << x->bits);
+    }
+    x->used  = 0;
+    x->stale = 0;
+    for (size_t i = x->first; i < x->cnt; i++) {
+        x->inputs[i].slots = 0;
+    }
+    for (size_t i = 0; i < oldSize; i++) {
+        if (old[i].fp && corpidx_isHeld(x, old[i].input)) {
+            corpidx_put(x, old[i].fp, old[i].input, old[i].off);
+        }
+    }
+    free(old);
+}
+
+/*
+ * Sets the budget of input bytes held by the index. The gear table is fixed (splitmix64 of the
+ * byte), so that fingerprints are reproducible
+ */
+static inline void corpidx_init(corpidx_t* x, size_t budget) {
+    for (size_t i = 0; i < ARRAYSIZE(x->gear); i++) {
+        uint64_t z = (i + 1) * 0x9E3779B97F4A7C15ULL;
+        z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        x->gear[i] = z ^ (z >> 31);
+    }
+    x->budget = budget;
+}
+
+/*
+ * Boundaries of 'len' bytes of an input, in '*cuts' (grown as needed, '*cap' entries), returns
+ * their number
+ */
+static inline size_t corpidx_cut(
+    const corpidx_t* x, const uint8_t* data, size_t len, corpidx_cut_t** cuts, size_t* cap) {
+    size_t   cnt = 0;
+    uint64_t h   = 0;
+    for (size_t i = 0; i < len; i++) {
+        h = corpidx_roll(x, h, data[i]);
+        if (i + 1 < CORPIDX_WINDOW || !corpidx_isBoundary(h)) {
+            continue;
+        }
+        if (cnt == *cap) {
+            *cap  = *cap ? *cap * 2 : 256;
+            *cuts = realloc(*cuts, *cap * sizeof((*cuts)[0]));
+            if (*cuts == NULL) {
+                LOG_F("realloc(nmemb=%zu) failed", *cap);
+            }
+        }
+        (*cuts)[cnt++] = (corpidx_cut_t){.fp = corpidx_fp(h), .off = (uint32_t)(i + 1)};
+    }
+    return cnt;
+}
+
+static inline void corpidx_evict(corpidx_t* x) {
+    corpidx_input_t* in = &x->inputs[x->first++];
+    x->bytes -= in->len;
+    x->stale += in->slots;
+    free(in->data);
+    *in = (corpidx_input_t){.data = NULL, .len = 0, .slots = 0};
+}
+
+/*
+ * Takes a new corpus input of 'len' bytes, malloc()-ed, with its boundaries from corpidx_cut(),
+ * evicting the oldest inputs if it doesn't fit in the budget. Returns false, and leaves 'data' to
+ * the caller, if it's too short to have a boundary or longer than the budget
+ */
+static inline bool corpidx_insert(
+    corpidx_t* x, uint8_t* data, size_t len, const corpidx_cut_t* cuts, size_t cutCnt) {
+    if (len <= CORPIDX_WINDOW || len > UINT32_MAX || len > x->budget || x->cnt == UINT32_MAX) {
+        return false;
+    }
+    while (x->bytes + len > x->budget) {
+        corpidx_evict(x);
+    }
+    if (x->cnt == x->cap) {
+        x->cap    = x->cap ? x->cap * 2 : 256;
+        x->inputs = realloc(x->inputs, x->cap * sizeof(x->inputs[0]));
+        if (x->inputs == NULL) {
+            LOG_F("realloc(nmemb=%zu) failed", x->cap);
+        }
+    }
+    uint32_t input   = (uint32_t)x->cnt++;
+    x->inputs[input] = (corpidx_input_t){.data = data, .len = len, .slots = 0};
+    x->bytes += len;
+
+    for (size_t i = 0; i < cutCnt; i++) {
+        if (x->slots == NULL || (x->used + 1) * 2 > ((size_t)1 << x->bits)) {
+            corpidx_rebuild(x);
+        }
+        corpidx_put(x, cuts[i].fp, input, cuts[i].off);
+    }
+    return true;
+}
+
+/*
+ * Rolls the hash '*h' over 'p' from '*pos' to the next boundary, and returns true with '*pos' just
+ * after it. Boundaries are only reported once CORPIDX_WINDOW bytes of 'p' were rolled, so the scan
+ * should start CORPIDX_WINDOW bytes before the first one of interest, or at the start of the input
+ */
+static inline bool corpidx_next(
+    const corpidx_t* x, const uint8_t* p, size_t len, size_t* pos, uint64_t* h) {
+    while (*pos < len) {
+        *h = corpidx_roll(x, *h, p[(*pos)++]);
+        if (*pos >= CORPIDX_WINDOW && corpidx_isBoundary(*h)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Held inputs which have the same content before a boundary with the hash 'h' */
+static inline size_t corpidx_lookup(
+    const corpidx_t* x, uint64_t h, corpidx_hit_t hits[CORPIDX_MAX_DUPS]) {
+    if (x->slots == NULL) {
+        return 0;
+    }
+    uint64_t fp   = corpidx_fp(h);
+    size_t   mask = ((size_t)1 << x->bits) - 1;
+    size_t   cnt  = 0;
+    for (size_t i = corpidx_slotOf(x, fp); x->slots[i].fp && cnt < CORPIDX_MAX_DUPS;
+         i = (i + 1) & mask) {
+        if (x->slots[i].fp == fp && corpidx_isHeld(x, x->slots[i].input)) {
+            const corpidx_input_t* in = &x->inputs[x->slots[i].input];
+            hits[cnt++] = (corpidx_hit_t){.data = in->data, .len = in->len, .off = x->slots[i].off};
+        }
+    }
+    return cnt;
+}
+
+#endif /* _HF_CORPIDX_H_ */
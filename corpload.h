@@ -0,0 +1,144 @@
+/*
+ * Honggfuzz+ - background loading of corpus files, for the corpus index of mangle_Splice
+ * -----------------------------------------
+ *
+ * Reading a new corpus input from disk in the fuzzing loop stalls it on slow disks, so the paths
+ * are queued instead, and read by CORPLOAD_THREADS threads started with the first one. Each file
+ * read is handed to the callback, in a malloc()-ed buffer which it takes over, so the operators
+ * only ever see inputs which are loaded already. The queue is bounded: paths pushed while
+ * CORPLOAD_QUEUE_LEN of them are waiting are dropped.
+ */
+
+#ifndef _HF_CORPLOAD_H_
+#define _HF_CORPLOAD_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+
+#define CORPLOAD_THREADS   2U
+#define CORPLOAD_QUEUE_LEN 4096U
+
+/* Takes over 'data', which holds the 'len' bytes of a loaded file */
+typedef void (*corpload_cb_t)(uint8_t* data, size_t len);
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    char*           paths[CORPLOAD_QUEUE_LEN];
+    size_t          head; /* paths[head % CORPLOAD_QUEUE_LEN] is the next one to load */
+    size_t          tail;
+    bool            started;
+    corpload_cb_t   cb;
+    size_t          maxLen; /* longer files are skipped */
+} corpload_t;
+
+#define CORPLOAD_INITIALIZER                                                                       \
+    { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER }
+
+/* The file at 'path' in a malloc()-ed buffer, NULL if it can't be read, is empty or too long */
+static inline uint8_t* corpload_read(const char* path, size_t maxLen, size_t* len) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= 0 || (uint64_t)st.st_size > maxLen) {
+        close(fd);
+        return NULL;
+    }
+    uint8_t* data = malloc((size_t)st.st_size);
+    if (data == NULL) {
+        LOG_F("malloc(size=%zu) failed", (size_t)st.st_size);
+    }
+    size_t got = 0;
+    while (got < (size_t)st.st_size) {
+        ssize_t n = read(fd, &data[got], (size_t)st.st_size - got);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        got += (size_t)n;
+    }
+    close(fd);
+    if (got == 0) {
+        free(data);
+        return NULL;
+    }
+    *len = got;
+    return data;
+}
+
+static void* corpload_thread(void* arg) {
+    corpload_t* l = arg;
+    for (;;) {
+        pthread_mutex_lock(&l->mutex);
+        while (l->head == l->tail) {
+            pthread_cond_wait(&l->cond, &l->mutex);
+        }
+        char* path = l->paths[l->head++ % CORPLOAD_QUEUE_LEN];
+        pthread_mutex_unlock(&l->mutex);
+
+        size_t   len;
+        uint8_t* data = corpload_read(path, l->maxLen, &len);
+        if (data) {
+            l->cb(data, len);
+        }
+        free(path);
+    }
+    return NULL;
+}
+
+__attribute__((noinline, cold)) static void corpload_start(corpload_t* l) {
+    sigset_t all, old;
+    sigfillset(&all);
+    /* Signals are left to the threads of the fuzzer */
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    for (size_t i = 0; i < CORPLOAD_THREADS; i++) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, corpload_thread, l) != 0) {
+            LOG_F("pthread_create() failed");
+        }
+        pthread_detach(t);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    l->started = true;
+}
+
+/* Queues the file at 'path' to be loaded, and handed to 'cb' */
+static inline void corpload_push(corpload_t* l, const char* path, size_t maxLen, corpload_cb_t cb) {
+    char* copy = strdup(path);
+    if (copy == NULL) {
+        LOG_F("strdup() failed");
+    }
+    pthread_mutex_lock(&l->mutex);
+    l->cb     = cb;
+    l->maxLen = maxLen;
+    if (!l->started) {
+        corpload_start(l);
+    }
+    if (l->tail - l->head == CORPLOAD_QUEUE_LEN) {
+        pthread_mutex_unlock(&l->mutex);
+        LOG_D("Corpus load queue is full, '%s' is dropped", path);
+        free(copy);
+        return;
+    }
+    l->paths[l->tail++ % CORPLOAD_QUEUE_LEN] = copy;
+    pthread_cond_signal(&l->cond);
+    pthread_mutex_unlock(&l->mutex);
+}
+
+#endif /* _HF_CORPLOAD_H_ */
@@ -0,0 +1,155 @@
+/*
+ * Honggfuzz+ - precompiled, memory-mapped dictionaries for mangle_StaticDict
+ * -----------------------------------------
+ *
+ * A dictionary file is built once by tools/hfdict (from AFL++ -x dictionaries and autodictionaries)
+ * and mapped read-only by each mutator instance, so parallel instances share the page cache
+ * instead of parsing the text and holding a copy each. Opening it costs one mmap() and a check of
+ * the token index, and picking a token one lookup.
+ *
+ * Layout, in the byte order of the machine which built it (a mismatch fails the magic check):
+ *
+ *   dictblob_hdr_t
+ *   dictblob_bucket_t[maxLen + 1]  tokens of each length: a range of the index
+ *   dictblob_tok_t[cnt]            offset and length of each token in the blob, by length
+ *   uint8_t[blobSize]              token bytes, each token once
+ */
+
+#ifndef _HF_DICTBLOB_H_
+#define _HF_DICTBLOB_H_
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DICTBLOB_MAGIC   "HFDICT\0\1"
+#define DICTBLOB_VERSION 1U
+/* Longest token kept by the converter */
+#define DICTBLOB_MAX_LEN 1024U
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t maxLen;
+    uint32_t cnt;
+    uint32_t reserved;
+    uint64_t bucketsOff;
+    uint64_t indexOff;
+    uint64_t blobOff;
+    uint64_t blobSize;
+} dictblob_hdr_t;
+
+typedef struct {
+    uint32_t first;
+    uint32_t cnt;
+} dictblob_bucket_t;
+
+typedef struct {
+    uint32_t off;
+    uint32_t len;
+} dictblob_tok_t;
+
+typedef struct {
+    const uint8_t*           map;
+    size_t                   mapSz;
+    const dictblob_bucket_t* buckets;
+    const dictblob_tok_t*    index;
+    const uint8_t*           blob;
+    uint32_t                 maxLen;
+    uint32_t                 cnt;
+} dictblob_t;
+
+static inline bool dictblob_inFile(uint64_t off, uint64_t len, size_t mapSz) {
+    return off <= mapSz && len <= (mapSz - off);
+}
+
+/*
+ * Maps the dictionary at 'path', and checks that all tokens are within it. Returns false, with the
+ * reason in 'err', if it can't be used
+ */
+static inline bool dictblob_open(dictblob_t* d, const char* path, const char** err) {
+    memset(d, 0, sizeof(*d));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        *err = "can't be opened";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(dictblob_hdr_t)) {
+        close(fd);
+        *err = "is too short";
+        return false;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        *err = "can't be mapped";
+        return false;
+    }
+    d->map   = map;
+    d->mapSz = (size_t)st.st_size;
+
+    const dictblob_hdr_t* hdr = map;
+    *err                      = "isn't a valid dictionary";
+    if (memcmp(hdr->magic, DICTBLOB_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != DICTBLOB_VERSION || hdr->maxLen > DICTBLOB_MAX_LEN ||
+        (hdr->bucketsOff % sizeof(uint32_t)) != 0 || (hdr->indexOff % sizeof(uint32_t)) != 0 ||
+        !dictblob_inFile(hdr->bucketsOff, (hdr->maxLen + 1ULL) * sizeof(dictblob_bucket_t),
+            d->mapSz) ||
+        !dictblob_inFile(hdr->indexOff, (uint64_t)hdr->cnt * sizeof(dictblob_tok_t), d->mapSz) ||
+        !dictblob_inFile(hdr->blobOff, hdr->blobSize, d->mapSz)) {
+        munmap(map, d->mapSz);
+        return false;
+    }
+    d->buckets = (const dictblob_bucket_t*)&d->map[hdr->bucketsOff];
+    d->index   = (const dictblob_tok_t*)&d->map[hdr->indexOff];
+    d->blob    = &d->map[hdr->blobOff];
+    d->maxLen  = hdr->maxLen;
+    d->cnt     = hdr->cnt;
+
+    for (uint32_t len = 0; len <= d->maxLen; len++) {
+        const dictblob_bucket_t* b = &d->buckets[len];
+        if (b->first > d->cnt || b->cnt > (d->cnt - b->first)) {
+            munmap(map, d->mapSz);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < d->cnt; i++) {
+        const dictblob_tok_t* t = &d->index[i];
+        if (t->len == 0 || t->len > d->maxLen || !dictblob_inFile(t->off, t->len, hdr->blobSize)) {
+            munmap(map, d->mapSz);
+            return false;
+        }
+    }
+    *err = NULL;
+    return true;
+}
+
+static inline void dictblob_close(dictblob_t* d) {
+    if (d->map) {
+        munmap((void*)d->map, d->mapSz);
+    }
+    memset(d, 0, sizeof(*d));
+}
+
+/* Token 'i' (< cnt) */
+static inline const uint8_t* dictblob_get(const dictblob_t* d, size_t i, size_t* len) {
+    *len = d->index[i].len;
+    return &d->blob[d->index[i].off];
+}
+
+/* Tokens of 'len' bytes: dictblob_cntOfLen() of them, from index dictblob_first() on */
+static inline size_t dictblob_cntOfLen(const dictblob_t* d, size_t len) {
+    return (len <= d->maxLen) ? d->buckets[len].cnt : 0;
+}
+
+static inline size_t dictblob_first(const dictblob_t* d, size_t len) {
+    return d->buckets[len].first;
+}
+
+#endif /* _HF_DICTBLOB_H_ */
@@ -0,0 +1,130 @@
+/*
+ * Honggfuzz+ - ranges of the input changed during a mutation round
+ * -----------------------------------------
+ *
+ * A small sorted set of disjoint [lo, hi) ranges, in offsets of the current input: insertions and
+ * deletions move the ranges after them, and an insertion inside a range extends it. Ranges which
+ * touch are merged, and when the set is full the two closest ones are, so it may cover bytes which
+ * weren't changed, but never misses one which was.
+ */
+
+#ifndef _HF_DIRTYSET_H_
+#define _HF_DIRTYSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libhfcommon/common.h"
+
+#define DIRTYSET_MAX_RANGES 32U
+
+typedef struct {
+    size_t lo;
+    size_t hi;
+} dirtyset_range_t;
+
+typedef struct {
+    dirtyset_range_t ranges[DIRTYSET_MAX_RANGES];
+    size_t           cnt;
+} dirtyset_t;
+
+static inline void dirtyset_reset(dirtyset_t* s) {
+    s->cnt = 0;
+}
+
+static inline void dirtyset_remove(dirtyset_t* s, size_t i) {
+    memmove(&s->ranges[i], &s->ranges[i + 1], (s->cnt - i - 1) * sizeof(s->ranges[0]));
+    s->cnt--;
+}
+
+/* Merges the two ranges with the smallest gap between them */
+static inline void dirtyset_squeeze(dirtyset_t* s) {
+    size_t best = 0;
+    for (size_t i = 1; (i + 1) < s->cnt; i++) {
+        if ((s->ranges[i + 1].lo - s->ranges[i].hi) <
+            (s->ranges[best + 1].lo - s->ranges[best].hi)) {
+            best = i;
+        }
+    }
+    s->ranges[best].hi = s->ranges[best + 1].hi;
+    dirtyset_remove(s, best + 1);
+}
+
+/* Bytes [off, off + len) were changed */
+static inline void dirtyset_mark(dirtyset_t* s, size_t off, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    size_t lo = off, hi = off + len;
+    size_t i  = 0;
+    while (i < s->cnt && s->ranges[i].hi < lo) {
+        i++;
+    }
+    /* Ranges [i, j) overlap or touch the new one */
+    size_t j = i;
+    while (j < s->cnt && s->ranges[j].lo <= hi) {
+        lo = HF_MIN(lo, s->ranges[j].lo);
+        hi = HF_MAX(hi, s->ranges[j].hi);
+        j++;
+    }
+    if (j > i) {
+        s->ranges[i] = (dirtyset_range_t){.lo = lo, .hi = hi};
+        memmove(&s->ranges[i + 1], &s->ranges[j], (s->cnt - j) * sizeof(s->ranges[0]));
+        s->cnt -= j - i - 1;
+        return;
+    }
+    if (s->cnt == DIRTYSET_MAX_RANGES) {
+        dirtyset_squeeze(s);
+        dirtyset_mark(s, off, len);
+        return;
+    }
+    memmove(&s->ranges[i + 1], &s->ranges[i], (s->cnt - i) * sizeof(s->ranges[0]));
+    s->ranges[i] = (dirtyset_range_t){.lo = lo, .hi = hi};
+    s->cnt++;
+}
+
+/* 'len' bytes were inserted at 'off', they're in the set if inserted inside one of its ranges */
+static inline void dirtyset_insert(dirtyset_t* s, size_t off, size_t len) {
+    for (size_t i = 0; i < s->cnt; i++) {
+        if (s->ranges[i].lo >= off) {
+            s->ranges[i].lo += len;
+        }
+        if (s->ranges[i].hi > off) {
+            s->ranges[i].hi += len;
+        }
+    }
+}
+
+/* Bytes [off, off + len) were deleted */
+static inline void dirtyset_delete(dirtyset_t* s, size_t off, size_t len) {
+    size_t end = off + len;
+    for (size_t i = 0; i < s->cnt;) {
+        dirtyset_range_t* r = &s->ranges[i];
+        r->lo = (r->lo <= off) ? r->lo : (r->lo >= end) ? (r->lo - len) : off;
+        r->hi = (r->hi <= off) ? r->hi : (r->hi >= end) ? (r->hi - len) : off;
+        if (r->lo == r->hi) {
+            dirtyset_remove(s, i);
+            continue;
+        }
+        if (i > 0 && s->ranges[i - 1].hi == r->lo) {
+            s->ranges[i - 1].hi = r->hi;
+            dirtyset_remove(s, i);
+            continue;
+        }
+        i++;
+    }
+}
+
+/* Whether any of bytes [off, off + len) is in the set */
+static inline bool dirtyset_overlaps(const dirtyset_t* s, size_t off, size_t len) {
+    for (size_t i = 0; i < s->cnt && s->ranges[i].lo < off + len; i++) {
+        if (s->ranges[i].hi > off) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif /* _HF_DIRTYSET_H_ */
@@ -0,0 +1,262 @@
+/*
+ * Honggfuzz+ - inline per-thread PRNG for the mangle operators
+ * -----------------------------------------
+ *
+ * Four interleaved xoshiro256** generators, stepped together, one per 64-bit lane of an AVX2
+ * register (or one after the other, without AVX2). Single draws are taken from a per-thread pool
+ * of FASTRND_POOL_WORDS words, refilled in one go, so the common case is one load and one compare.
+ * Coin flips use one bit of a pooled word each.
+ *
+ * Bounded draws use Lemire's multiply-shift with rejection of the biased low range, so they are
+ * exactly uniform and, except when rejecting, don't divide. Bulk fills write generator output
+ * straight to the destination; the printable fill maps 16-bit words with a multiply-high to
+ * 32..126, a deviation from uniform below 0.2%.
+ *
+ * The state is seeded from util_rnd64() on first use in each thread, or with fastrnd_seed().
+ */
+
+#ifndef _HF_FASTRND_H_
+#define _HF_FASTRND_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+#include "libhfcommon/util.h"
+#include "memswap.h"
+
+#define FASTRND_LANES      4U
+#define FASTRND_POOL_WORDS 64U
+
+typedef struct {
+    uint64_t s[4][FASTRND_LANES];
+    uint64_t pool[FASTRND_POOL_WORDS];
+    unsigned poolIdx;
+    uint64_t bits;
+    unsigned bitsLeft;
+    bool     seeded;
+} fastrnd_t;
+
+static __thread fastrnd_t fastrnd_state;
+
+static inline uint64_t fastrnd_splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline void fastrnd_seed(uint64_t seed) {
+    fastrnd_t* st = &fastrnd_state;
+    for (unsigned w = 0; w < 4; w++) {
+        for (unsigned l = 0; l < FASTRND_LANES; l++) {
+            st->s[w][l] = fastrnd_splitmix64(&seed);
+        }
+    }
+    st->poolIdx  = FASTRND_POOL_WORDS;
+    st->bitsLeft = 0;
+    st->seeded   = true;
+}
+
+/*
+ * One step of all lanes, 32 bytes of output. x * 5 and x * 9 are spelled as shifts and adds, as
+ * there's no 64-bit lane multiply below AVX-512.
+ */
+__attribute__((always_inline)) static inline void fastrnd_step(
+    uint64_t s[4][FASTRND_LANES], uint64_t out[FASTRND_LANES]) {
+    for (unsigned l = 0; l < FASTRND_LANES; l++) {
+        uint64_t x = s[1][l] + (s[1][l] << 2);
+        x          = (x << 7) | (x >> 57);
+        out[l]     = x + (x << 3);
+
+        uint64_t t = s[1][l] << 17;
+        s[2][l] ^= s[0][l];
+        s[3][l] ^= s[1][l];
+        s[1][l] ^= s[2][l];
+        s[0][l] ^= s[3][l];
+        s[2][l] ^= t;
+        s[3][l] = (s[3][l] << 45) | (s[3][l] >> 19);
+    }
+}
+
+/* Writes 'steps' * 32 bytes to 'out', which needn't be aligned */
+__attribute__((always_inline)) static inline void fastrnd_genBody(
+    uint64_t s[4][FASTRND_LANES], uint8_t* out, size_t steps) {
+    uint64_t st[4][FASTRND_LANES];
+    memcpy(st, s, sizeof(st));
+    for (size_t i = 0; i < steps; i++) {
+        uint64_t r[FASTRND_LANES];
+        fastrnd_step(st, r);
+        memcpy(&out[i * sizeof(r)], r, sizeof(r));
+    }
+    memcpy(s, st, sizeof(st));
+}
+
+/* 16-bit words to 32..126 */
+__attribute__((always_inline)) static inline void fastrnd_printableBody(
+    uint8_t* out, const uint16_t* in, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)(32U + (((uint32_t)in[i] * 95U) >> 16));
+    }
+}
+
+static void fastrnd_genScalar(uint64_t s[4][FASTRND_LANES], uint8_t* out, size_t steps) {
+    fastrnd_genBody(s, out, steps);
+}
+
+static void fastrnd_printableScalar(uint8_t* out, const uint16_t* in, size_t len) {
+    fastrnd_printableBody(out, in, len);
+}
+
+#if defined(_HF_MEMSWAP_X86)
+HF_ATTR_AVX2 static inline __m256i fastrnd_rotl256(__m256i v, int k) {
+    return _mm256_or_si256(_mm256_slli_epi64(v, k), _mm256_srli_epi64(v, 64 - k));
+}
+
+/* Same steps as fastrnd_step(), one lane per 64-bit element */
+HF_ATTR_AVX2 static void fastrnd_genAVX2(uint64_t s[4][FASTRND_LANES], uint8_t* out, size_t steps) {
+    __m256i s0 = _mm256_loadu_si256((const __m256i*)s[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i*)s[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i*)s[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i*)s[3]);
+    for (size_t i = 0; i < steps; i++) {
+        __m256i x = fastrnd_rotl256(_mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2)), 7);
+        _mm256_storeu_si256((__m256i*)&out[i * 32], _mm256_add_epi64(x, _mm256_slli_epi64(x, 3)));
+
+        __m256i t = _mm256_slli_epi64(s1, 17);
+        s2        = _mm256_xor_si256(s2, s0);
+        s3        = _mm256_xor_si256(s3, s1);
+        s1        = _mm256_xor_si256(s1, s2);
+        s0        = _mm256_xor_si256(s0, s3);
+        s2        = _mm256_xor_si256(s2, t);
+        s3        = fastrnd_rotl256(s3, 45);
+    }
+    _mm256_storeu_si256((__m256i*)s[0], s0);
+    _mm256_storeu_si256((__m256i*)s[1], s1);
+    _mm256_storeu_si256((__m256i*)s[2], s2);
+    _mm256_storeu_si256((__m256i*)s[3], s3);
+}
+
+HF_ATTR_AVX2 static void fastrnd_printableAVX2(uint8_t* out, const uint16_t* in, size_t len) {
+    fastrnd_printableBody(out, in, len);
+}
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+static inline void fastrnd_gen(uint8_t* out, size_t steps) {
+    fastrnd_t* st = &fastrnd_state;
+    if (!st->seeded) {
+        fastrnd_seed(util_rnd64());
+    }
+#if defined(_HF_MEMSWAP_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        fastrnd_genAVX2(st->s, out, steps);
+        return;
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    fastrnd_genScalar(st->s, out, steps);
+}
+
+static inline void fastrnd_printable16(uint8_t* out, const uint16_t* in, size_t len) {
+#if defined(_HF_MEMSWAP_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        fastrnd_printableAVX2(out, in, len);
+        return;
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    fastrnd_printableScalar(out, in, len);
+}
+
+__attribute__((noinline)) static void fastrnd_refill(void) {
+    fastrnd_gen((uint8_t*)fastrnd_state.pool, FASTRND_POOL_WORDS / FASTRND_LANES);
+    fastrnd_state.poolIdx = 0;
+}
+
+static inline uint64_t fastrnd_u64(void) {
+    if (__builtin_expect(fastrnd_state.poolIdx >= FASTRND_POOL_WORDS, 0)) {
+        fastrnd_refill();
+    }
+    return fastrnd_state.pool[fastrnd_state.poolIdx++];
+}
+
+static inline bool fastrnd_bit(void) {
+    if (fastrnd_state.bitsLeft == 0) {
+        fastrnd_state.bits     = fastrnd_u64();
+        fastrnd_state.bitsLeft = 64;
+    }
+    bool bit = fastrnd_state.bits & 1;
+    fastrnd_state.bits >>= 1;
+    fastrnd_state.bitsLeft--;
+    return bit;
+}
+
+/* Uniform in [0, range), range > 0 */
+static inline uint64_t fastrnd_below(uint64_t range) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t m = (__uint128_t)fastrnd_u64() * range;
+    uint64_t    l = (uint64_t)m;
+    if (__builtin_expect(l < range, 0)) {
+        uint64_t t = -range % range;
+        while (l < t) {
+            m = (__uint128_t)fastrnd_u64() * range;
+            l = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
+#else
+    /* No 64x64->128 multiply, reject the top partial range and divide instead */
+    uint64_t lim = UINT64_MAX - (UINT64_MAX % range);
+    uint64_t r;
+    do {
+        r = fastrnd_u64();
+    } while (r >= lim);
+    return r % range;
+#endif /* defined(__SIZEOF_INT128__) */
+}
+
+/* Uniform in [min, max], same contract as util_rndGet() */
+static inline uint64_t fastrnd_get(uint64_t min, uint64_t max) {
+    if (min > max) {
+        LOG_F("min:%" PRIu64 " > max:%" PRIu64, min, max);
+    }
+    uint64_t range = max - min + 1;
+    if (range == 0) {
+        return fastrnd_u64();
+    }
+    return min + fastrnd_below(range);
+}
+
+static inline uint8_t fastrnd_printable(void) {
+    return (uint8_t)(32U + fastrnd_below(95));
+}
+
+static inline void fastrnd_buf(uint8_t* buf, size_t sz) {
+    const size_t stepSz = FASTRND_LANES * sizeof(uint64_t);
+    size_t       steps  = sz / stepSz;
+    if (steps) {
+        fastrnd_gen(buf, steps);
+    }
+    for (size_t i = steps * stepSz; i < sz;) {
+        uint64_t r = fastrnd_u64();
+        size_t   n = HF_MIN(sz - i, sizeof(r));
+        memcpy(&buf[i], &r, n);
+        i += n;
+    }
+}
+
+static inline void fastrnd_bufPrintable(uint8_t* buf, size_t sz) {
+    /* 2 bytes of entropy per output byte, produced in chunks on the stack */
+    uint16_t tmp[256] __attribute__((aligned(32)));
+    while (sz > 0) {
+        size_t n = HF_MIN(sz, ARRAYSIZE(tmp));
+        fastrnd_buf((uint8_t*)tmp, n * sizeof(tmp[0]));
+        fastrnd_printable16(buf, tmp, n);
+        buf += n;
+        sz -= n;
+    }
+}
+
+#endif /* _HF_FASTRND_H_ */
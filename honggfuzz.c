@@ -0,0 +1,584 @@
+/*
+ * AFL++ custom mutator bridge for the Honggfuzz+ mangle.c, replaces
+ * custom_mutators/honggfuzz/honggfuzz.c from the AFL++ tree.
+ *
+ * Changes to the AFL++ version:
+ * - New corpus entries found with this mutator credit the operators which
+ *   produced them (mangle_creditLastRound), for the adaptive scheduler.
+ * - Per-operator counters are written to mangle_stats, next to fuzzer_stats.
+ * - With HONGGFUZZ_PATCHLOG=1, queue entries and crashes are named after the
+ *   operators which produced them (afl_custom_describe), and the edits which
+ *   produced a queue entry are saved to mangle_patches/, under its name.
+ * - Queue entries are indexed by content (mangle_addCorpusFile), for the
+ *   splices of mangle_Splice.
+ * - With HONGGFUZZ_PIPELINE=<threads>, mutants of the current seed are made
+ *   ahead by worker threads (mutpipe.h), and afl_custom_fuzz only dequeues
+ *   one. Their rounds aren't credited to the operators, nor named, and the
+ *   workers pick the operators from the scheduler of afl_custom_fuzz, as it
+ *   was when the seed was set (mangle_getSchedule).
+ * - With HONGGFUZZ_BATCH=<mutants>, afl_custom_fuzz makes that many mutants
+ *   of the seed at once (mangle_mangleBatch), within the havoc budget given
+ *   to afl_custom_fuzz_count, and hands them out one per call. Each is credited
+ *   to the operators it used, which are charged the time spent making it and
+ *   the time until the next one runs (mangle_runBatchMutant). Only the last
+ *   one of each batch is named.
+ * - Mutants are made in a persistent, 64-byte aligned buffer, and handed out
+ *   from it. Between two rounds of the same seed only the bytes which the
+ *   previous one may have changed are copied back (mangle_restoreSeed), not
+ *   the whole seed.
+ * - Built with -DHF_DIRTY_WRITE=1, the mutator delivers the testcases to the
+ *   target itself (afl_custom_fuzz_send): the testcase file (or stdin file,
+ *   or shared memory) is written in place, and between two mutants of the
+ *   same seed only the ranges which either of them changed are written.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define __USE_GNU
+#include <sys/mman.h>
+
+#include "custom_mutator_helpers.h"
+#include "mangle.h"
+#include "mutpipe.h"
+
+#define NUMBER_OF_MUTATIONS 5
+#define BATCH_MAX 1024
+
+/* Testcases are written by afl_custom_fuzz_send, instead of AFL++ */
+#if !defined(HF_DIRTY_WRITE)
+  #define HF_DIRTY_WRITE 0
+#endif
+
+uint8_t          *queue_input;
+size_t            queue_input_size;
+afl_state_t      *afl_struct;
+run_t             run;
+honggfuzz_t       global;
+struct _dynfile_t dynfile;
+
+typedef struct my_mutator {
+
+  afl_state_t *afl;
+  run_t       *run;
+  u8          *mutator_buf;
+  unsigned int seed;
+  unsigned int extras_cnt, a_extras_cnt;
+  mutpipe_t   *pipe;
+  u8           new_seed;
+  u8           made_ahead;         /* by a pipeline worker, not credited */
+  u8           not_last;           /* a batch mutant but the last, not named */
+  const u8    *buf_seed;           /* the seed of mutator_buf, or NULL */
+  size_t       buf_seed_size;
+#if HF_DIRTY_WRITE
+  /* The testcase holds a mutant of out_seed which changed out_changed, and
+     everything from out_moved_from on */
+  int          out_fd;
+  const u8    *out_seed;
+  size_t       out_seed_size, out_size, out_moved_from;
+  dirtyset_t   out_changed;
+#endif
+  u8          *batch_buf;
+  size_t      *batch_offs, *batch_sizes;
+  size_t       batch_max, batch_cnt, batch_next;
+  u32          budget_left;
+
+} my_mutator_t;
+
+my_mutator_t *afl_custom_init(afl_state_t *afl, unsigned int seed) {
+
+  my_mutator_t *data = calloc(1, sizeof(my_mutator_t));
+  if (!data) {
+
+    perror("afl_custom_init alloc");
+    return NULL;
+
+  }
+
+  if (posix_memalign((void **)&data->mutator_buf, 64, MAX_FILE) != 0) {
+
+    free(data);
+    perror("mutator_buf alloc");
+    return NULL;
+
+  }
+
+  run.dynfile = &dynfile;
+  run.global = &global;
+  data->afl = afl;
+  data->seed = seed;
+  data->run = &run;
+  afl_struct = afl;
+#if HF_DIRTY_WRITE
+  data->out_fd = -1;
+#endif
+
+  run.global->mutate.maxInputSz = MAX_FILE;
+  run.global->mutate.mutationsPerRun = NUMBER_OF_MUTATIONS;
+  run.mutationsPerRun = NUMBER_OF_MUTATIONS;
+  run.global->timing.lastCovUpdate = 6;
+
+  // global->feedback.cmpFeedback
+  // global->feedback.cmpFeedbackMap
+
+  char stats_file[PATH_MAX];
+  snprintf(stats_file, sizeof(stats_file), "%s/mangle_stats", afl->out_dir);
+  mangle_setStatsFile(stats_file);
+
+  if (mangle_patchLogEnabled()) {
+
+    char patches_dir[PATH_MAX];
+    snprintf(patches_dir, sizeof(patches_dir), "%s/mangle_patches",
+             afl->out_dir);
+    if (mkdir(patches_dir, 0700) != 0 && errno != EEXIST) {
+
+      perror("mkdir mangle_patches");
+
+    }
+
+  }
+
+  const char *pipeline = getenv("HONGGFUZZ_PIPELINE");
+  if (pipeline && *pipeline && strcmp(pipeline, "0")) {
+
+    unsigned long threads = strtoul(pipeline, NULL, 10);
+    if (threads == 0 || threads > MUTPIPE_MAX_WORKERS) {
+
+      fprintf(stderr, "Invalid HONGGFUZZ_PIPELINE='%s', expected 0..%u\n",
+              pipeline, MUTPIPE_MAX_WORKERS);
+      exit(EXIT_FAILURE);
+
+    }
+
+    if ((data->pipe = malloc(sizeof(mutpipe_t))) == NULL) {
+
+      perror("mutpipe alloc");
+      exit(EXIT_FAILURE);
+
+    }
+
+    mutpipe_init(data->pipe, threads, &global, MAX_FILE);
+
+  }
+
+  const char *batch = getenv("HONGGFUZZ_BATCH");
+  if (!data->pipe && batch && *batch && strcmp(batch, "0")) {
+
+    unsigned long mutants = strtoul(batch, NULL, 10);
+    if (mutants == 0 || mutants > BATCH_MAX) {
+
+      fprintf(stderr, "Invalid HONGGFUZZ_BATCH='%s', expected 0..%u\n", batch,
+              BATCH_MAX);
+      exit(EXIT_FAILURE);
+
+    }
+
+    /* Room for the first mutant at any offset up to MAX_FILE */
+    data->batch_max = mutants;
+    data->batch_buf = malloc(2 * MAX_FILE);
+    data->batch_offs = calloc(mutants, sizeof(size_t));
+    data->batch_sizes = calloc(mutants, sizeof(size_t));
+    if (!data->batch_buf || !data->batch_offs || !data->batch_sizes) {
+
+      perror("batch alloc");
+      exit(EXIT_FAILURE);
+
+    }
+
+  }
+
+  return data;
+
+}
+
+/* When a new queue entry is added we check if there are new dictionary
+   entries to add to honggfuzz structure */
+
+uint8_t afl_custom_queue_new_entry(my_mutator_t  *data,
+                                   const uint8_t *filename_new_queue,
+                                   const uint8_t *filename_orig_queue) {
+
+  /* Only entries found by executing our own output are credited to the
+     mangle operators, not imported ones or those from other stages */
+  if (filename_orig_queue && data->afl->stage_short &&
+      !strcmp((char *)data->afl->stage_short, "custom") && !data->made_ahead) {
+
+    mangle_creditLastRound(&run);
+
+    if (mangle_patchLogEnabled() && !data->not_last) {
+
+      const char *name = strrchr((const char *)filename_new_queue, '/');
+      char        patch_file[PATH_MAX];
+      snprintf(patch_file, sizeof(patch_file), "%s/mangle_patches/%s",
+               data->afl->out_dir,
+               name ? name + 1 : (const char *)filename_new_queue);
+      mangle_saveLastRound(patch_file, (const char *)filename_orig_queue);
+
+    }
+
+  }
+
+  /* Read in the background, the fuzzing loop doesn't wait for the disk */
+  mangle_addCorpusFile((const char *)filename_new_queue);
+
+  if (run.global->mutate.dictionaryCnt >= 1024) return 0;
+
+  while (data->extras_cnt < data->afl->extras_cnt &&
+         run.global->mutate.dictionaryCnt < 1024) {
+
+    memcpy(run.global->mutate.dictionary[run.global->mutate.dictionaryCnt].val,
+           data->afl->extras[data->extras_cnt].data,
+           data->afl->extras[data->extras_cnt].len);
+    run.global->mutate.dictionary[run.global->mutate.dictionaryCnt].len =
+        data->afl->extras[data->extras_cnt].len;
+    /* Published after the token, for the pipeline workers */
+    __atomic_store_n(&run.global->mutate.dictionaryCnt,
+                     run.global->mutate.dictionaryCnt + 1, __ATOMIC_RELEASE);
+    data->extras_cnt++;
+
+  }
+
+  while (data->a_extras_cnt < data->afl->a_extras_cnt &&
+         run.global->mutate.dictionaryCnt < 1024) {
+
+    memcpy(run.global->mutate.dictionary[run.global->mutate.dictionaryCnt].val,
+           data->afl->a_extras[data->a_extras_cnt].data,
+           data->afl->a_extras[data->a_extras_cnt].len);
+    run.global->mutate.dictionary[run.global->mutate.dictionaryCnt].len =
+        data->afl->a_extras[data->a_extras_cnt].len;
+    __atomic_store_n(&run.global->mutate.dictionaryCnt,
+                     run.global->mutate.dictionaryCnt + 1, __ATOMIC_RELEASE);
+    data->a_extras_cnt++;
+
+  }
+
+  return 0;
+
+}
+
+#if HF_DIRTY_WRITE
+/* AFL++ writes the testcase file by unlinking it and creating it again, so
+   the fd of the previous one is dropped, and the testcase opened again when
+   it's next sent. The stdin file is AFL++'s own, and stays */
+static void testcase_close(my_mutator_t *data) {
+
+  if (data->out_fd != -1 && !data->afl->fsrv.use_stdin) close(data->out_fd);
+  data->out_fd = -1;
+
+}
+
+#endif
+
+/* we could set only_printable if is_ascii is set ... let's see */
+uint8_t afl_custom_queue_get(my_mutator_t *data, const uint8_t *filename) {
+
+  (void)filename;
+  /* The mutants of the pipeline, and mutator_buf, are of the previous seed */
+  data->new_seed = 1;
+  data->buf_seed = NULL;
+#if HF_DIRTY_WRITE
+  data->out_seed = NULL;
+  testcase_close(data);
+#endif
+  // run.global->cfg.only_printable = ...
+  return 1;
+
+}
+
+/* The havoc budget which AFL++ gives the stage without this callback, the
+   batch of the previous seed is dropped */
+uint32_t afl_custom_fuzz_count(my_mutator_t *data, const u8 *buf,
+                               size_t buf_size) {
+
+  (void)buf;
+  (void)buf_size;
+
+  data->batch_cnt = data->batch_next = 0;
+  data->budget_left = data->afl->stage_max;
+  data->buf_seed = NULL;
+#if HF_DIRTY_WRITE
+  /* Trimming writes the testcase behind our back, into a new file */
+  data->out_seed = NULL;
+  testcase_close(data);
+#endif
+  return data->afl->stage_max;
+
+}
+
+/* Makes the next batch of mutants of the seed, as many of the remaining
+   budget as fit */
+static void batch_refill(my_mutator_t *data, uint8_t *buf, size_t buf_size) {
+
+  size_t cnt = data->batch_max;
+  if (data->budget_left > 0 && data->budget_left < cnt)
+    cnt = data->budget_left;
+
+  /* Made from a copy, mangle_Splice reads the seed in queue_input */
+  memcpy(data->mutator_buf, buf, buf_size);
+  queue_input = data->mutator_buf;
+  queue_input_size = buf_size;
+  run.dynfile->data = data->mutator_buf;
+  run.dynfile->size = buf_size;
+  data->buf_seed = NULL;
+  mangle_newSeed();
+  data->batch_cnt =
+      mangle_mangleBatch(&run, NUMBER_OF_MUTATIONS, data->batch_buf,
+                         2 * MAX_FILE, data->batch_offs, data->batch_sizes, cnt);
+  data->batch_next = 0;
+
+}
+
+/* here we run the honggfuzz mutator, which is really good */
+
+size_t afl_custom_fuzz(my_mutator_t *data, uint8_t *buf, size_t buf_size,
+                       u8 **out_buf, uint8_t *add_buf, size_t add_buf_size,
+                       size_t max_size) {
+
+  (void)add_buf;
+  (void)add_buf_size;
+
+  if (data->pipe) {
+
+    if (data->new_seed || buf_size != data->pipe->seedSize ||
+        max_size != run.global->mutate.maxInputSz) {
+
+      if (run.global->mutate.maxInputSz != max_size)
+        __atomic_store_n(&run.global->mutate.maxInputSz, max_size,
+                         __ATOMIC_RELEASE);
+      mutpipe_setSeed(data->pipe, buf, buf_size, NUMBER_OF_MUTATIONS);
+      data->new_seed = 0;
+
+    }
+
+    /* Mutated ahead, or here if the workers are behind */
+    const mutpipe_slot_t *slot = mutpipe_pop(data->pipe);
+    data->made_ahead = slot != NULL;
+    if (slot) {
+
+      *out_buf = slot->data;
+      return slot->size;
+
+    }
+
+  }
+
+  if (data->batch_max) {
+
+    if (data->new_seed || buf_size != queue_input_size ||
+        max_size != run.global->mutate.maxInputSz) {
+
+      data->batch_cnt = data->batch_next = 0;
+      data->new_seed = 0;
+
+    }
+
+    if (run.global->mutate.maxInputSz != max_size)
+      __atomic_store_n(&run.global->mutate.maxInputSz, max_size,
+                       __ATOMIC_RELEASE);
+    if (data->batch_next == data->batch_cnt)
+      batch_refill(data, buf, buf_size);
+
+    if (data->batch_next < data->batch_cnt) {
+
+      size_t i = data->batch_next++;
+      if (data->budget_left > 0) data->budget_left--;
+      /* Credited and charged as itself, but only the last round of the batch
+         is named */
+      mangle_runBatchMutant(i);
+      data->not_last = data->batch_next != data->batch_cnt;
+      *out_buf = data->batch_buf + data->batch_offs[i];
+      return data->batch_sizes[i];
+
+    }
+
+  }
+
+  /* mutator_buf holds the output of the previous round, if it was made from
+     this seed only the bytes which it changed are copied back */
+  if (data->buf_seed == buf && data->buf_seed_size == buf_size) {
+
+    mangle_restoreSeed(data->mutator_buf, buf, buf_size);
+
+  } else {
+
+    memcpy(data->mutator_buf, buf, buf_size);
+    mangle_newSeed();
+
+  }
+  data->buf_seed = buf;
+  data->buf_seed_size = buf_size;
+  queue_input = data->mutator_buf;
+  run.dynfile->data = data->mutator_buf;
+  queue_input_size = buf_size;
+  run.dynfile->size = buf_size;
+  /* Read by the pipeline workers, set when it changes only */
+  if (run.global->mutate.maxInputSz != max_size)
+    __atomic_store_n(&run.global->mutate.maxInputSz, max_size,
+                     __ATOMIC_RELEASE);
+
+  /* the mutation */
+  mangle_mangleContent(&run, NUMBER_OF_MUTATIONS);
+
+  /* return size of mutated data */
+  *out_buf = data->mutator_buf;
+  return run.dynfile->size;
+
+}
+
+/* Names new queue entries and crashes after the mangle operators which
+   produced them, with HONGGFUZZ_PATCHLOG=1 */
+const char *afl_custom_describe(my_mutator_t *data,
+                                size_t        max_description_len) {
+
+  if (data->made_ahead || data->not_last) return NULL;
+  return mangle_describeLastRound(max_description_len);
+
+}
+
+#if HF_DIRTY_WRITE
+/* Writes bytes [off, off + len) of the testcase */
+static void testcase_write(my_mutator_t *data, const u8 *buf, size_t off,
+                           size_t len) {
+
+  if (data->afl->fsrv.use_shmem_fuzz) {
+
+    memcpy(data->afl->fsrv.shmem_fuzz + off, buf + off, len);
+    return;
+
+  }
+
+  if (pwrite(data->out_fd, buf + off, len, off) != (ssize_t)len) {
+
+    perror("pwrite testcase");
+    exit(EXIT_FAILURE);
+
+  }
+
+}
+
+/* Delivers every testcase in place of AFL++. If it's the output of a round
+   and the testcase holds another output of the same seed, the bytes outside
+   the ranges which either round changed are the same, and aren't written */
+void afl_custom_fuzz_send(my_mutator_t *data, const u8 *buf, size_t buf_size) {
+
+  afl_forkserver_t *fsrv = &data->afl->fsrv;
+
+  if (fsrv->use_shmem_fuzz && buf_size > MAX_FILE) buf_size = MAX_FILE;
+  if (!fsrv->use_shmem_fuzz && data->out_fd == -1) {
+
+    data->out_fd = fsrv->use_stdin
+                       ? fsrv->out_fd
+                       : open((char *)fsrv->out_file, O_RDWR | O_CREAT, 0600);
+    if (data->out_fd == -1) {
+
+      perror("open testcase");
+      exit(EXIT_FAILURE);
+
+    }
+
+  }
+
+  const u8  *seed = NULL;
+  dirtyset_t changed;
+  size_t     moved_from = 0;
+  if (buf == data->mutator_buf && data->buf_seed) {
+
+    seed = data->buf_seed;
+    mangle_lastRoundChanges(&changed, &moved_from);
+
+  }
+
+  if (seed && seed == data->out_seed &&
+      data->buf_seed_size == data->out_seed_size) {
+
+    dirtyset_t both = changed;
+    size_t     from = HF_MIN(moved_from, data->out_moved_from);
+    for (size_t i = 0; i < data->out_changed.cnt; i++) {
+
+      dirtyset_mark(&both, data->out_changed.ranges[i].lo,
+                    data->out_changed.ranges[i].hi -
+                        data->out_changed.ranges[i].lo);
+
+    }
+
+    from = HF_MIN(from, buf_size);
+    for (size_t i = 0; i < both.cnt && both.ranges[i].lo < from; i++) {
+
+      size_t hi = HF_MIN(both.ranges[i].hi, from);
+      testcase_write(data, buf, both.ranges[i].lo, hi - both.ranges[i].lo);
+
+    }
+
+    testcase_write(data, buf, from, buf_size - from);
+
+  } else {
+
+    testcase_write(data, buf, 0, buf_size);
+    data->out_size = SIZE_MAX;
+
+  }
+
+  if (fsrv->use_shmem_fuzz) {
+
+    *fsrv->shmem_fuzz_len = buf_size;
+
+  } else {
+
+    if (buf_size != data->out_size && ftruncate(data->out_fd, buf_size)) {
+
+      perror("ftruncate testcase");
+      exit(EXIT_FAILURE);
+
+    }
+
+    if (fsrv->use_stdin) lseek(data->out_fd, 0, SEEK_SET);
+
+  }
+
+  data->out_seed = seed;
+  data->out_seed_size = data->buf_seed_size;
+  data->out_size = buf_size;
+  if (seed) {
+
+    data->out_changed = changed;
+    data->out_moved_from = moved_from;
+
+  }
+
+}
+
+#endif
+
+/**
+ * Deinitialize everything
+ *
+ * @param data The data ptr from afl_custom_init
+ */
+void afl_custom_deinit(my_mutator_t *data) {
+
+  if (data->pipe) {
+
+    mutpipe_destroy(data->pipe);
+    free(data->pipe);
+
+  }
+
+  mangle_writeStats();
+#if HF_DIRTY_WRITE
+  testcase_close(data);
+#endif
+  free(data->batch_buf);
+  free(data->batch_offs);
+  free(data->batch_sizes);
+  free(data->mutator_buf);
+  free(data);
+
+}
+
@@ -0,0 +1,275 @@
+/*
+ * Honggfuzz+ - length and offset distributions for the mangle operators
+ * -----------------------------------------
+ *
+ * lendist_get(kind, max) returns a value in <1:max> with one random draw and one table lookup:
+ *
+ * - default: the original mangle_getLen(), i.e. 1/2 uniform, 1/2 uniform below a uniform bound.
+ * - uniform.
+ * - geometric: mean of LENDIST_GEOMETRIC_MEAN bytes, whatever the size of the input.
+ * - powerlaw: P(len >= k) = 1/k (Pareto with alpha = 2, floored), whatever the size of the input.
+ *
+ * For max <= LENDIST_SMALL_MAX every kind has an exact alias table per max. Above it, a draw picks
+ * a point of an inverse CDF (LENDIST_QSZ intervals, linearly interpolated): as a fraction of max
+ * for the default kind, which is scale-free, or in bytes (20.12 fixed point) for the geometric and
+ * power-law kinds, which are redrawn if they exceed max. Their unbounded last interval takes
+ * another draw.
+ */
+
+#ifndef _HF_LENDIST_H_
+#define _HF_LENDIST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "fastrnd.h"
+#include "honggfuzz.h"
+#include "libhfcommon/log.h"
+
+typedef enum {
+    LENDIST_DEFAULT = 0,
+    LENDIST_UNIFORM,
+    LENDIST_GEOMETRIC,
+    LENDIST_POWERLAW,
+    LENDIST_CNT,
+} lendist_kind_t;
+
+static const char* const lendist_names[LENDIST_CNT] = {
+    [LENDIST_DEFAULT]   = "default",
+    [LENDIST_UNIFORM]   = "uniform",
+    [LENDIST_GEOMETRIC] = "geometric",
+    [LENDIST_POWERLAW]  = "powerlaw",
+};
+
+#define LENDIST_SMALL_MAX      32U
+#define LENDIST_QBITS          10U
+#define LENDIST_QSZ            (1U << LENDIST_QBITS)
+#define LENDIST_FRAC_BITS      22U
+#define LENDIST_FIXED_BITS     12U
+#define LENDIST_GEOMETRIC_MEAN 8.0
+
+/* Alias tables: (column probability << 8) | alias, the probability has 24 bits */
+static uint32_t lendist_small[LENDIST_CNT][LENDIST_SMALL_MAX + 1][LENDIST_SMALL_MAX];
+static uint32_t lendist_quant[LENDIST_CNT][LENDIST_QSZ + 1];
+
+static inline bool lendist_scaleFree(lendist_kind_t kind) {
+    return kind == LENDIST_DEFAULT;
+}
+
+/*
+ * Natural logarithm for the table construction, so that the mutator doesn't need libm (the AFL++
+ * Makefile doesn't link it): x = m * 2^e with m in [1, 2), ln(m) = 2 * atanh((m - 1) / (m + 1))
+ */
+static double lendist_log(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int      e     = (int)((bits >> 52) & 0x7FF) - 1023;
+    uint64_t mbits = (bits & 0xFFFFFFFFFFFFFULL) | (1023ULL << 52);
+    double   m;
+    memcpy(&m, &mbits, sizeof(m));
+
+    double t = (m - 1.0) / (m + 1.0), t2 = t * t, term = t, sum = 0.0;
+    for (int k = 1; k < 60; k += 2) {
+        sum += term / k;
+        term *= t2;
+    }
+    return e * 0.69314718055994530942 + 2.0 * sum;
+}
+
+/* Exact probabilities of 1..max */
+static void lendist_pmf(lendist_kind_t kind, size_t max, double* p) {
+    double sum = 0.0;
+    for (size_t k = max; k >= 1; k--) {
+        switch (kind) {
+        case LENDIST_DEFAULT:
+            /* Tail sum of 1/j, j=k..max, accumulated from the top */
+            sum += 1.0 / (double)k;
+            p[k - 1] = 0.5 / (double)max + 0.5 * sum / (double)max;
+            break;
+        case LENDIST_UNIFORM:
+            p[k - 1] = 1.0;
+            break;
+        case LENDIST_GEOMETRIC:
+            p[k - 1] = 1.0;
+            for (size_t i = 1; i < k; i++) {
+                p[k - 1] *= (1.0 - 1.0 / LENDIST_GEOMETRIC_MEAN);
+            }
+            break;
+        case LENDIST_POWERLAW:
+            p[k - 1] = 1.0 / (double)k - 1.0 / (double)(k + 1);
+            break;
+        default:
+            break;
+        }
+    }
+    double total = 0.0;
+    for (size_t k = 0; k < max; k++) {
+        total += p[k];
+    }
+    for (size_t k = 0; k < max; k++) {
+        p[k] /= total;
+    }
+}
+
+/* Vose's alias method, as in opsched_rebuild() */
+static void lendist_buildAlias(const double* p, size_t n, uint32_t* out) {
+    double  scaled[LENDIST_SMALL_MAX];
+    uint8_t small[LENDIST_SMALL_MAX], large[LENDIST_SMALL_MAX];
+    size_t  smallCnt = 0, largeCnt = 0;
+    for (size_t i = 0; i < n; i++) {
+        scaled[i] = p[i] * n;
+        if (scaled[i] < 1.0) {
+            small[smallCnt++] = (uint8_t)i;
+        } else {
+            large[largeCnt++] = (uint8_t)i;
+        }
+    }
+    while (smallCnt > 0 && largeCnt > 0) {
+        uint8_t l = small[--smallCnt];
+        uint8_t g = large[largeCnt - 1];
+        out[l]    = ((uint32_t)(scaled[l] * 16777216.0) << 8) | g;
+        scaled[g] -= (1.0 - scaled[l]);
+        if (scaled[g] < 1.0) {
+            largeCnt--;
+            small[smallCnt++] = g;
+        }
+    }
+    while (largeCnt > 0) {
+        uint8_t g = large[--largeCnt];
+        out[g]    = (0xFFFFFFU << 8) | g;
+    }
+    while (smallCnt > 0) {
+        uint8_t l = small[--smallCnt];
+        out[l]    = (0xFFFFFFU << 8) | l;
+    }
+}
+
+/* CDF of len/max for the default kind, as max grows: x/2 + (x - x*ln(x))/2 */
+static inline double lendist_defaultCdf(double x) {
+    return (x <= 0.0) ? 0.0 : (x - 0.5 * x * lendist_log(x));
+}
+
+/* Inverse CDF at u, in table units */
+static double lendist_quantile(lendist_kind_t kind, double u) {
+    switch (kind) {
+    case LENDIST_DEFAULT: {
+        double lo = 0.0, hi = 1.0;
+        for (int i = 0; i < 64; i++) {
+            double mid = (lo + hi) / 2.0;
+            if (lendist_defaultCdf(mid) < u) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return hi * 4294967296.0;
+    }
+    case LENDIST_UNIFORM:
+        return u * 4294967296.0;
+    case LENDIST_GEOMETRIC:
+        /* len - 1 = floor(Exp(m)), with P(len > k) = (1 - 1/mean)^k */
+        if (u >= 1.0) {
+            return 4294967296.0;
+        }
+        return lendist_log(1.0 - u) / lendist_log(1.0 - 1.0 / LENDIST_GEOMETRIC_MEAN) *
+               (1U << LENDIST_FIXED_BITS);
+    case LENDIST_POWERLAW:
+        /* len = floor(1 / (1 - u)) */
+        if (u >= 1.0) {
+            return 4294967296.0;
+        }
+        return (1.0 / (1.0 - u) - 1.0) * (1U << LENDIST_FIXED_BITS);
+    default:
+        return 0.0;
+    }
+}
+
+__attribute__((constructor)) static void lendist_init(void) {
+    double p[LENDIST_SMALL_MAX];
+    for (unsigned kind = 0; kind < LENDIST_CNT; kind++) {
+        for (size_t max = 1; max <= LENDIST_SMALL_MAX; max++) {
+            lendist_pmf((lendist_kind_t)kind, max, p);
+            lendist_buildAlias(p, max, lendist_small[kind][max]);
+        }
+        for (size_t i = 0; i <= LENDIST_QSZ; i++) {
+            double q = lendist_quantile((lendist_kind_t)kind, (double)i / LENDIST_QSZ);
+            lendist_quant[kind][i] = (q >= (double)UINT32_MAX) ? UINT32_MAX : (uint32_t)q;
+        }
+    }
+}
+
+__attribute__((noinline, cold)) static void lendist_badMax(size_t max) {
+    if (max == 0) {
+        LOG_F("max == 0");
+    }
+    LOG_F("max (%zu) > _HF_INPUT_MAX_SIZE (%zu)", max, (size_t)_HF_INPUT_MAX_SIZE);
+}
+
+/* A value in <1:max> */
+static inline size_t lendist_get(lendist_kind_t kind, size_t max) {
+    if (__builtin_expect((max - 1) >= _HF_INPUT_MAX_SIZE, 0)) {
+        lendist_badMax(max);
+    }
+    if (kind == LENDIST_UNIFORM) {
+        return 1 + (size_t)fastrnd_below(max);
+    }
+    /* Tail of the absolute kinds, see below */
+    uint64_t add = 0, scale = 1;
+    for (;;) {
+        uint64_t rnd = fastrnd_u64();
+        if (max <= LENDIST_SMALL_MAX) {
+            /* Upper 32 bits pick the column, lower 24 bits decide between it and its alias */
+            uint32_t col = (uint32_t)(((rnd >> 32) * max) >> 32);
+            uint32_t e   = lendist_small[kind][max][col];
+            return 1 + (((uint32_t)rnd & 0xFFFFFFU) < (e >> 8) ? col : (e & 0xFFU));
+        }
+
+        const uint32_t* q    = lendist_quant[kind];
+        size_t          idx  = (size_t)(rnd >> (64 - LENDIST_QBITS));
+        uint64_t        frac = (rnd >> (64 - LENDIST_QBITS - LENDIST_FRAC_BITS)) &
+                        ((1ULL << LENDIST_FRAC_BITS) - 1);
+        uint64_t val = q[idx] + (((uint64_t)(q[idx + 1] - q[idx]) * frac) >> LENDIST_FRAC_BITS);
+
+        if (lendist_scaleFree(kind)) {
+            return 1 + (size_t)((val * max) >> 32);
+        }
+
+        /*
+         * The last interval of the absolute kinds is unbounded, so it's drawn again instead of
+         * interpolated: the geometric tail past its start is the same distribution shifted by it,
+         * the power-law one the same distribution scaled by LENDIST_QSZ
+         */
+        if (idx == (LENDIST_QSZ - 1)) {
+            if (kind == LENDIST_GEOMETRIC) {
+                add += q[idx];
+            } else {
+                scale *= LENDIST_QSZ;
+            }
+            if ((add >> LENDIST_FIXED_BITS) < max && scale <= max) {
+                continue;
+            }
+        } else {
+            size_t len = (size_t)(scale + ((scale * (add + val)) >> LENDIST_FIXED_BITS));
+            if (len <= max) {
+                return len;
+            }
+        }
+        add   = 0;
+        scale = 1;
+    }
+}
+
+static inline bool lendist_parse(const char* name, lendist_kind_t* kind) {
+    for (unsigned i = 0; i < LENDIST_CNT; i++) {
+        if (strcasecmp(name, lendist_names[i]) == 0) {
+            *kind = (lendist_kind_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif /* _HF_LENDIST_H_ */
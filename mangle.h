@@ -0,0 +1,130 @@
+/*
+ *
+ * honggfuzz - buffer mangling routines
+ * -----------------------------------------
+ *
+ * Author: Robert Swiecki <swiecki@google.com>
+ *
+ * Copyright 2010-2018 by Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ */
+
+#ifndef _HF_MANGLE_H_
+#define _HF_MANGLE_H_
+
+#include "dirtyset.h"
+#include "honggfuzz.h"
+#include "opsched.h"
+
+extern void mangle_mangleContent(run_t* run, int speed_factor);
+
+/*
+ * Must be called before a round whose input isn't that of the previous round of this thread (e.g.
+ * after a copy of another seed, and not after mangle_restoreSeed()). Outputs are hashed from the
+ * hash of the input, computed once per seed, and the bytes the round changed, for the filter of
+ * recent outputs (see HONGGFUZZ_DEDUP), which would compare outputs of different seeds otherwise.
+ * The first round of a thread hashes its input anyway
+ */
+extern void mangle_newSeed(void);
+
+/*
+ * Up to 'cnt' mangle_mangleContent() rounds of the input in run->dynfile, which is left as it was,
+ * their setup done once. Mutant 'i' is written at out + offs[i] and has sizes[i] bytes, the mutants
+ * start 64-byte aligned in the 'cap' bytes of 'out', and each needs mutate.maxInputSz bytes of
+ * room while it's made, so fewer may fit. Returns the number of mutants made. The last one is the
+ * round mangle_describeLastRound() refers to
+ */
+extern size_t mangle_mangleBatch(run_t* run, int speed_factor, uint8_t* out, size_t cap,
+    size_t* offs, size_t* sizes, size_t cnt);
+
+/*
+ * Mutant 'i' of the last mangle_mangleBatch() call is about to run: it's charged the time spent
+ * making it, and the time until the next one runs, and mangle_creditLastRound() refers to it
+ */
+extern void mangle_runBatchMutant(size_t i);
+
+/*
+ * The input produced by the last mangle_mangleContent() call in this thread was added to the
+ * corpus, credit the operators which were used to create it
+ */
+extern void mangle_creditLastRound(run_t* run);
+
+/*
+ * The operator picks of the adaptive scheduler of this thread, into 't'. A thread given them with
+ * mangle_followSchedule() picks the operators as this one does from then on, and its rounds aren't
+ * charged or credited: pipeline workers, whose mutants aren't credited, follow the fuzz callback
+ */
+extern void mangle_getSchedule(opsched_table_t* t);
+extern void mangle_followSchedule(const opsched_table_t* t);
+
+/*
+ * 'size' bytes at 'data', which must stay valid and unchanged until the next call, are those which
+ * mangle_Splice() falls back to in this thread, instead of input_getRandomInputAsBuf()'s. Pipeline
+ * workers give their copy of the seed, as the bridge rewrites the buffer of the latter
+ */
+extern void mangle_setSpliceInput(const uint8_t* data, size_t size);
+
+/*
+ * 'data' holds the output of the last mangle_mangleContent() round of this thread, made from the
+ * 'size' bytes of 'seed': copies back the bytes which the round may have changed, so that it holds
+ * the seed again, without a full copy
+ */
+extern void mangle_restoreSeed(uint8_t* data, const uint8_t* seed, size_t size);
+
+/*
+ * Ranges of its seed which the last mangle_mangleContent() round of this thread may have changed:
+ * those it overwrote, in 'changed', all below 'movedFrom', the offset from which on insertions and
+ * deletions moved the bytes (SIZE_MAX if there were none). The bytes which mangle_restoreSeed()
+ * copies back
+ */
+extern void mangle_lastRoundChanges(dirtyset_t* changed, size_t* movedFrom);
+
+/*
+ * Same as mangle_restoreSeed(), for an output made from 'seed' by any round, whose changes were
+ * kept from mangle_lastRoundChanges()
+ */
+extern void mangle_restoreChanges(
+    uint8_t* data, const uint8_t* seed, size_t size, const dirtyset_t* changed, size_t movedFrom);
+
+/*
+ * Per-operator counters are written to 'path' every few seconds, and on mangle_writeStats(). NULL
+ * disables them
+ */
+extern void mangle_setStatsFile(const char* path);
+extern void mangle_writeStats(void);
+
+/*
+ * With HONGGFUZZ_PATCHLOG=1 the edits of each mangle_mangleContent() round are logged, see
+ * patchlog.h. mangle_describeLastRound() names the operators which produced the last output of this
+ * thread ("hf:<operator>+..."), in at most 'maxLen' bytes including the NUL, or returns NULL.
+ * mangle_saveLastRound() writes its log to 'path', noting the 'parent' input (can be NULL), and
+ * mangle_replay() applies a saved log to 'size' bytes of 'data', with room for 'cap' bytes,
+ * returning the new size, or SIZE_MAX if the log doesn't apply
+ */
+extern bool        mangle_patchLogEnabled(void);
+extern const char* mangle_describeLastRound(size_t maxLen);
+extern bool        mangle_saveLastRound(const char* path, const char* parent);
+extern size_t      mangle_replay(const char* path, uint8_t* data, size_t size, size_t cap);
+
+/*
+ * Adds a new corpus input to the index used by mangle_Splice, which keeps a copy of it. Returns false
+ * if it wasn't added: it's too short (64 bytes at most), or longer than the memory budget of the
+ * index (HONGGFUZZ_SPLICE_MEM, in MiB, default: 256). Older inputs are evicted to make room for it.
+ * mangle_addCorpusFile() does the same with the file at 'path', which is read in the background
+ */
+extern bool mangle_addCorpusInput(const uint8_t* data, size_t len);
+extern void mangle_addCorpusFile(const char* path);
+
+#endif
@@ -0,0 +1,341 @@
+/*
+ * Honggfuzz+ - kernels for the mangle_MemSwap variants
+ * -----------------------------------------
+ *
+ * memswap_Baseline() is the original HonggFuzz swap. The two cipher-based kernels walk the head of the two regions forwards and the tail backwards, exactly like the
+ * scalar loop in mangle_MemSwap: the bytes taken from the second region are pushed through the AES
+ * reverse S-box (and, for the Feistel variant, mixed with the mirrored byte from the tail), while
+ * the bytes of the first region are moved over unchanged.
+ *
+ * If the regions don't overlap, every output byte depends only on the original content, so the
+ * work can be done 16 (SSSE3) or 32 (AVX2) bytes at a time. The 256-entry S-box lookup is done
+ * with 16 PSHUFB lookups over 16-byte slices of the table, and the mirrored tail is handled with
+ * byte-reversing shuffles. Overlapping regions are order-dependent, so they always take the scalar
+ * path. The output is bit-identical to the scalar code in all cases.
+ */
+
+#ifndef _HF_MEMSWAP_H_
+#define _HF_MEMSWAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _HF_MEMSWAP_X86 1
+#define HF_ATTR_SSE2  __attribute__((target("sse2")))
+#define HF_ATTR_SSSE3 __attribute__((target("ssse3")))
+#define HF_ATTR_AVX2  __attribute__((target("avx2")))
+#endif /* defined(__x86_64__) || defined(__i386__) */
+
+/* AES reverse S-box */
+static const uint8_t memswap_sbox[256] __attribute__((aligned(64))) = {
+    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+    0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+    0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+    0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+    0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+    0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+    0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+    0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+    0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+    0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+    0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+    0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+    0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+    0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+    0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+    0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d,
+};
+
+/* Substitution followed by a left rotation by 'rot' bits */
+static inline uint8_t memswap_subRotL(uint8_t val, unsigned rot) {
+    uint8_t s = memswap_sbox[val];
+    return (uint8_t)((s << rot) | (s >> (8 - rot)));
+}
+
+/* Feistel round: (S(l) << 5) | ((S(l) >> 3) ^ r) */
+static inline uint8_t memswap_feistel(uint8_t l, uint8_t r) {
+    uint8_t s = memswap_sbox[l];
+    return (uint8_t)((s << 5) | ((s >> 3) ^ r));
+}
+
+static inline bool memswap_overlaps(size_t off1, size_t off2, size_t len) {
+    return (off1 < off2 + len) && (off2 < off1 + len);
+}
+
+/*
+ * Scalar reference versions. The order of loads and stores inside an iteration is significant for
+ * overlapping regions, so don't reorder them.
+ */
+static inline void memswap_scalarSP(
+    uint8_t* data, size_t off1, size_t off2, size_t len, size_t from) {
+    for (size_t i = from; i < (len / 2); i++) {
+        uint8_t tmp_left           = data[off2 + i];
+        data[off2 + i]             = data[off1 + i];
+        data[off1 + i]             = memswap_subRotL(tmp_left, 5);
+        uint8_t tmp_right          = data[off2 + (len - 1) - i];
+        data[off2 + (len - 1) - i] = data[off1 + (len - 1) - i];
+        data[off1 + (len - 1) - i] = memswap_subRotL(tmp_right, 3);
+    }
+}
+
+static inline void memswap_scalarFL(
+    uint8_t* data, size_t off1, size_t off2, size_t len, size_t from) {
+    for (size_t i = from; i < (len / 2); i++) {
+        uint8_t tmp_left           = data[off2 + i];
+        uint8_t tmp_right          = data[off2 + (len - 1) - i];
+        data[off2 + i]             = data[off1 + i];
+        data[off1 + i]             = memswap_feistel(tmp_left, tmp_right);
+        data[off2 + (len - 1) - i] = data[off1 + (len - 1) - i];
+        data[off1 + (len - 1) - i] = tmp_left;
+    }
+}
+
+static inline void memswap_scalarBaseline(uint8_t* data, size_t off1, size_t off2, size_t len) {
+    for (size_t i = 0; i < (len / 2); i++) {
+        uint8_t tmp1               = data[off2 + i];
+        data[off2 + i]             = data[off1 + i];
+        data[off1 + i]             = tmp1;
+        uint8_t tmp2               = data[off2 + (len - 1) - i];
+        data[off2 + (len - 1) - i] = data[off1 + (len - 1) - i];
+        data[off1 + (len - 1) - i] = tmp2;
+    }
+}
+
+/* Swaps two non-overlapping ranges, in chunks which the compiler turns into vector moves */
+static inline void memswap_swapRange(uint8_t* a, uint8_t* b, size_t len) {
+    uint8_t tmp[64];
+    while (len > 0) {
+        size_t sz = len < sizeof(tmp) ? len : sizeof(tmp);
+        memcpy(tmp, a, sz);
+        memcpy(a, b, sz);
+        memcpy(b, tmp, sz);
+        a += sz;
+        b += sz;
+        len -= sz;
+    }
+}
+
+#if defined(_HF_MEMSWAP_X86)
+
+/*
+ * 256-entry lookup with PSHUFB: slice k of the table is only selected for bytes whose high nibble
+ * is k. XOR-ing with (k << 4) and adding 0x70 with unsigned saturation leaves bit 7 clear only for
+ * those bytes, and PSHUFB returns zero for every index with bit 7 set.
+ */
+HF_ATTR_SSSE3 static inline __m128i memswap_lookup128(const __m128i tbl[16], __m128i v) {
+    __m128i res = _mm_setzero_si128();
+    for (int k = 0; k < 16; k++) {
+        __m128i idx = _mm_adds_epu8(_mm_xor_si128(v, _mm_set1_epi8((char)(k << 4))),
+            _mm_set1_epi8(0x70));
+        res         = _mm_or_si128(res, _mm_shuffle_epi8(tbl[k], idx));
+    }
+    return res;
+}
+
+/* There's no 8-bit shift, so shift 16-bit lanes and mask out bits crossing byte boundaries */
+HF_ATTR_SSSE3 static inline __m128i memswap_rotL128(__m128i v, int rot) {
+    __m128i hi = _mm_and_si128(_mm_slli_epi16(v, rot), _mm_set1_epi8((char)(0xFF << rot)));
+    __m128i lo =
+        _mm_and_si128(_mm_srli_epi16(v, 8 - rot), _mm_set1_epi8((char)(0xFF >> (8 - rot))));
+    return _mm_or_si128(hi, lo);
+}
+
+HF_ATTR_SSSE3 static inline __m128i memswap_feistel128(__m128i s, __m128i r) {
+    __m128i hi = _mm_and_si128(_mm_slli_epi16(s, 5), _mm_set1_epi8((char)0xE0));
+    __m128i lo = _mm_and_si128(_mm_srli_epi16(s, 3), _mm_set1_epi8(0x1F));
+    return _mm_or_si128(hi, _mm_xor_si128(lo, r));
+}
+
+HF_ATTR_SSSE3 static inline __m128i memswap_reverse128(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+HF_ATTR_SSSE3 static inline void memswap_loadTbl128(__m128i tbl[16]) {
+    for (int k = 0; k < 16; k++) {
+        tbl[k] = _mm_load_si128((const __m128i*)&memswap_sbox[k * 16]);
+    }
+}
+
+HF_ATTR_SSSE3 static void memswap_ssse3SP(uint8_t* data, size_t off1, size_t off2, size_t len) {
+    __m128i tbl[16];
+    memswap_loadTbl128(tbl);
+
+    uint8_t*     d1 = &data[off1];
+    uint8_t*     d2 = &data[off2];
+    const size_t h  = len / 2;
+    size_t       i  = 0;
+    for (; (i + 16) <= h; i += 16) {
+        size_t  t     = len - i - 16;
+        __m128i head1 = _mm_loadu_si128((const __m128i*)&d1[i]);
+        __m128i head2 = _mm_loadu_si128((const __m128i*)&d2[i]);
+        __m128i tail1 = _mm_loadu_si128((const __m128i*)&d1[t]);
+        __m128i tail2 = _mm_loadu_si128((const __m128i*)&d2[t]);
+        _mm_storeu_si128((__m128i*)&d2[i], head1);
+        _mm_storeu_si128((__m128i*)&d2[t], tail1);
+        _mm_storeu_si128((__m128i*)&d1[i], memswap_rotL128(memswap_lookup128(tbl, head2), 5));
+        _mm_storeu_si128((__m128i*)&d1[t], memswap_rotL128(memswap_lookup128(tbl, tail2), 3));
+    }
+    memswap_scalarSP(data, off1, off2, len, i);
+}
+
+HF_ATTR_SSSE3 static void memswap_ssse3FL(uint8_t* data, size_t off1, size_t off2, size_t len) {
+    __m128i tbl[16];
+    memswap_loadTbl128(tbl);
+
+    uint8_t*     d1 = &data[off1];
+    uint8_t*     d2 = &data[off2];
+    const size_t h  = len / 2;
+    size_t       i  = 0;
+    for (; (i + 16) <= h; i += 16) {
+        size_t  t     = len - i - 16;
+        __m128i head1 = _mm_loadu_si128((const __m128i*)&d1[i]);
+        __m128i head2 = _mm_loadu_si128((const __m128i*)&d2[i]);
+        __m128i tail1 = _mm_loadu_si128((const __m128i*)&d1[t]);
+        __m128i right = memswap_reverse128(_mm_loadu_si128((const __m128i*)&d2[t]));
+        _mm_storeu_si128((__m128i*)&d2[i], head1);
+        _mm_storeu_si128((__m128i*)&d2[t], tail1);
+        _mm_storeu_si128(
+            (__m128i*)&d1[i], memswap_feistel128(memswap_lookup128(tbl, head2), right));
+        _mm_storeu_si128((__m128i*)&d1[t], memswap_reverse128(head2));
+    }
+    memswap_scalarFL(data, off1, off2, len, i);
+}
+
+/* VPSHUFB works within 128-bit lanes, so each slice of the table is broadcast to both lanes */
+HF_ATTR_AVX2 static inline __m256i memswap_lookup256(const __m256i tbl[16], __m256i v) {
+    __m256i res = _mm256_setzero_si256();
+    for (int k = 0; k < 16; k++) {
+        __m256i idx = _mm256_adds_epu8(
+            _mm256_xor_si256(v, _mm256_set1_epi8((char)(k << 4))), _mm256_set1_epi8(0x70));
+        res         = _mm256_or_si256(res, _mm256_shuffle_epi8(tbl[k], idx));
+    }
+    return res;
+}
+
+HF_ATTR_AVX2 static inline __m256i memswap_rotL256(__m256i v, int rot) {
+    __m256i hi = _mm256_and_si256(_mm256_slli_epi16(v, rot), _mm256_set1_epi8((char)(0xFF << rot)));
+    __m256i lo = _mm256_and_si256(
+        _mm256_srli_epi16(v, 8 - rot), _mm256_set1_epi8((char)(0xFF >> (8 - rot))));
+    return _mm256_or_si256(hi, lo);
+}
+
+HF_ATTR_AVX2 static inline __m256i memswap_feistel256(__m256i s, __m256i r) {
+    __m256i hi = _mm256_and_si256(_mm256_slli_epi16(s, 5), _mm256_set1_epi8((char)0xE0));
+    __m256i lo = _mm256_and_si256(_mm256_srli_epi16(s, 3), _mm256_set1_epi8(0x1F));
+    return _mm256_or_si256(hi, _mm256_xor_si256(lo, r));
+}
+
+/* Reverse bytes within each lane, then swap the lanes */
+HF_ATTR_AVX2 static inline __m256i memswap_reverse256(__m256i v) {
+    const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15,
+        14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, rev), 0x4E);
+}
+
+HF_ATTR_AVX2 static inline void memswap_loadTbl256(__m256i tbl[16]) {
+    for (int k = 0; k < 16; k++) {
+        tbl[k] = _mm256_broadcastsi128_si256(
+            _mm_load_si128((const __m128i*)&memswap_sbox[k * 16]));
+    }
+}
+
+HF_ATTR_AVX2 static void memswap_avx2SP(uint8_t* data, size_t off1, size_t off2, size_t len) {
+    __m256i tbl[16];
+    memswap_loadTbl256(tbl);
+
+    uint8_t*     d1 = &data[off1];
+    uint8_t*     d2 = &data[off2];
+    const size_t h  = len / 2;
+    size_t       i  = 0;
+    for (; (i + 32) <= h; i += 32) {
+        size_t  t     = len - i - 32;
+        __m256i head1 = _mm256_loadu_si256((const __m256i*)&d1[i]);
+        __m256i head2 = _mm256_loadu_si256((const __m256i*)&d2[i]);
+        __m256i tail1 = _mm256_loadu_si256((const __m256i*)&d1[t]);
+        __m256i tail2 = _mm256_loadu_si256((const __m256i*)&d2[t]);
+        _mm256_storeu_si256((__m256i*)&d2[i], head1);
+        _mm256_storeu_si256((__m256i*)&d2[t], tail1);
+        _mm256_storeu_si256((__m256i*)&d1[i], memswap_rotL256(memswap_lookup256(tbl, head2), 5));
+        _mm256_storeu_si256((__m256i*)&d1[t], memswap_rotL256(memswap_lookup256(tbl, tail2), 3));
+    }
+    memswap_scalarSP(data, off1, off2, len, i);
+}
+
+HF_ATTR_AVX2 static void memswap_avx2FL(uint8_t* data, size_t off1, size_t off2, size_t len) {
+    __m256i tbl[16];
+    memswap_loadTbl256(tbl);
+
+    uint8_t*     d1 = &data[off1];
+    uint8_t*     d2 = &data[off2];
+    const size_t h  = len / 2;
+    size_t       i  = 0;
+    for (; (i + 32) <= h; i += 32) {
+        size_t  t     = len - i - 32;
+        __m256i head1 = _mm256_loadu_si256((const __m256i*)&d1[i]);
+        __m256i head2 = _mm256_loadu_si256((const __m256i*)&d2[i]);
+        __m256i tail1 = _mm256_loadu_si256((const __m256i*)&d1[t]);
+        __m256i right = memswap_reverse256(_mm256_loadu_si256((const __m256i*)&d2[t]));
+        _mm256_storeu_si256((__m256i*)&d2[i], head1);
+        _mm256_storeu_si256((__m256i*)&d2[t], tail1);
+        _mm256_storeu_si256(
+            (__m256i*)&d1[i], memswap_feistel256(memswap_lookup256(tbl, head2), right));
+        _mm256_storeu_si256((__m256i*)&d1[t], memswap_reverse256(head2));
+    }
+    memswap_scalarFL(data, off1, off2, len, i);
+}
+
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+/*
+ * Baseline swap of data[off1, off1 + len) and data[off2, off2 + len). Without overlap it's a plain
+ * exchange of the heads and of the tails (the middle byte of an odd length stays in place)
+ */
+static inline void memswap_Baseline(uint8_t* data, size_t off1, size_t off2, size_t len) {
+    if (memswap_overlaps(off1, off2, len)) {
+        memswap_scalarBaseline(data, off1, off2, len);
+        return;
+    }
+    const size_t h = len / 2;
+    memswap_swapRange(&data[off1], &data[off2], h);
+    memswap_swapRange(&data[off1 + len - h], &data[off2 + len - h], h);
+}
+
+/* Substitution-Permutation swap of data[off1, off1 + len) and data[off2, off2 + len) */
+static inline void memswap_SP(uint8_t* data, size_t off1, size_t off2, size_t len) {
+#if defined(_HF_MEMSWAP_X86)
+    if (!memswap_overlaps(off1, off2, len) && (len / 2) >= 16) {
+        if (__builtin_cpu_supports("avx2") && (len / 2) >= 32) {
+            memswap_avx2SP(data, off1, off2, len);
+            return;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            memswap_ssse3SP(data, off1, off2, len);
+            return;
+        }
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    memswap_scalarSP(data, off1, off2, len, /* from= */ 0);
+}
+
+/* Feistel Network swap of data[off1, off1 + len) and data[off2, off2 + len) */
+static inline void memswap_FL(uint8_t* data, size_t off1, size_t off2, size_t len) {
+#if defined(_HF_MEMSWAP_X86)
+    if (!memswap_overlaps(off1, off2, len) && (len / 2) >= 16) {
+        if (__builtin_cpu_supports("avx2") && (len / 2) >= 32) {
+            memswap_avx2FL(data, off1, off2, len);
+            return;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            memswap_ssse3FL(data, off1, off2, len);
+            return;
+        }
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    memswap_scalarFL(data, off1, off2, len, /* from= */ 0);
+}
+
+#endif /* _HF_MEMSWAP_H_ */
@@ -0,0 +1,260 @@
+/*
+ * Honggfuzz+ - pipeline of mutants produced by background threads
+ * -----------------------------------------
+ *
+ * With fast targets afl-fuzz waits for mangle_mangleContent() between executions. In pipelined
+ * mode, worker threads run it on private copies of the current seed (their own run_t and
+ * dynfile_t, the mangle state being per-thread already, and the copy as the input which
+ * mangle_Splice() falls back to), and each of them fills its own ring of MUTPIPE_DEPTH
+ * preallocated slots. A ring has one producer and one consumer, so it needs no lock:
+ * the worker publishes a slot by advancing 'head' (release), and the fuzz callback takes the
+ * oldest slot of the next ring with a mutant, round-robin, and hands out its buffer. The slot is
+ * given back by the next mutpipe_pop(), AFL++ runs the target with it in between. A slot which
+ * held a mutant of the same seed is turned back into the seed by copying the ranges which that
+ * round changed, not the whole seed.
+ *
+ * Each seed has a generation: mutpipe_setSeed() bumps it when AFL++ moves to another seed, and the
+ * mutants of older generations still in the rings are dropped as they're dequeued, so the rings are
+ * flushed without stopping the workers. mutpipe_pop() returns NULL if no mutant of the current seed
+ * is ready, and the caller mutates it itself then, so it never waits for the workers. They sleep
+ * before the first seed, and when their ring is full, until half of it is free again.
+ */
+
+#ifndef _HF_MUTPIPE_H_
+#define _HF_MUTPIPE_H_
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dirtyset.h"
+#include "honggfuzz.h"
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+#include "libhfcommon/util.h"
+#include "mangle.h"
+
+#define MUTPIPE_MAX_WORKERS 16U
+/* Slots per ring, a power of 2 */
+#define MUTPIPE_DEPTH 8U
+
+typedef struct {
+    uint8_t*   data;
+    size_t     size;
+    uint64_t   gen;
+    dirtyset_t changed; /* ranges of the seed which the mutant changed, and all from movedFrom on */
+    size_t     movedFrom;
+} mutpipe_slot_t;
+
+struct mutpipe;
+
+typedef struct {
+    mutpipe_slot_t  slots[MUTPIPE_DEPTH];
+    uint64_t        head; /* written by the worker */
+    uint64_t        tail; /* written by the consumer */
+    bool            sleeping;
+    pthread_t       thread;
+    struct mutpipe* pipe;
+} mutpipe_ring_t;
+
+typedef struct mutpipe {
+    mutpipe_ring_t  rings[MUTPIPE_MAX_WORKERS];
+    size_t          cnt;
+    size_t          next; /* ring to look at first */
+    mutpipe_ring_t* held; /* ring whose oldest slot was handed out */
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    bool            stop;
+    /*
+     * The seed, its generation (0: none yet), the arguments of the rounds, and the operator picks
+     * of the consumer's scheduler when the seed was set, under 'mutex'
+     */
+    uint8_t*        seed;
+    size_t          seedSize;
+    uint64_t        gen;
+    honggfuzz_t*    global;
+    size_t          cap; /* bytes of each slot */
+    int             speedFactor;
+    opsched_table_t sched;
+} mutpipe_t;
+
+static inline bool mutpipe_isFull(const mutpipe_ring_t* r, uint64_t head, size_t free) {
+    return (head - __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST)) > (MUTPIPE_DEPTH - free);
+}
+
+/* Sleeps until the ring has 'free' slots, returns false if the pipeline is stopping */
+static bool mutpipe_waitRoom(mutpipe_ring_t* r, uint64_t head, size_t free) {
+    mutpipe_t* p = r->pipe;
+    pthread_mutex_lock(&p->mutex);
+    __atomic_store_n(&r->sleeping, true, __ATOMIC_SEQ_CST);
+    while (!p->stop && (p->gen == 0 || mutpipe_isFull(r, head, free))) {
+        pthread_cond_wait(&p->cond, &p->mutex);
+    }
+    __atomic_store_n(&r->sleeping, false, __ATOMIC_RELAXED);
+    bool stop = p->stop;
+    pthread_mutex_unlock(&p->mutex);
+    return !stop;
+}
+
+static void* mutpipe_worker(void* arg) {
+    mutpipe_ring_t* r = arg;
+    mutpipe_t*      p = r->pipe;
+    dynfile_t       dynfile;
+    run_t           run;
+    memset(&dynfile, '\0', sizeof(dynfile));
+    memset(&run, '\0', sizeof(run));
+    run.dynfile = &dynfile;
+    run.global  = p->global;
+
+    uint8_t*        seed        = util_Malloc(p->cap);
+    size_t          seedSize    = 0;
+    uint64_t        gen         = 0;
+    int             speedFactor = 0;
+    opsched_table_t sched;
+    for (uint64_t head = 0;; head++) {
+        if (mutpipe_isFull(r, head, 1) || __atomic_load_n(&p->gen, __ATOMIC_ACQUIRE) == 0) {
+            if (!mutpipe_waitRoom(r, head, MUTPIPE_DEPTH / 2)) {
+                break;
+            }
+        }
+        if (__atomic_load_n(&p->gen, __ATOMIC_ACQUIRE) != gen) {
+            pthread_mutex_lock(&p->mutex);
+            memcpy(seed, p->seed, p->seedSize);
+            seedSize            = p->seedSize;
+            gen                 = p->gen;
+            speedFactor         = p->speedFactor;
+            run.mutationsPerRun = p->global->mutate.mutationsPerRun;
+            sched               = p->sched;
+            pthread_mutex_unlock(&p->mutex);
+            mangle_newSeed();
+            mangle_followSchedule(&sched);
+            mangle_setSpliceInput(seed, seedSize);
+        }
+
+        mutpipe_slot_t* s = &r->slots[head % MUTPIPE_DEPTH];
+        if (s->gen == gen) {
+            /* An older mutant of the same seed, the bytes which it didn't change are the seed's */
+            mangle_restoreChanges(s->data, seed, seedSize, &s->changed, s->movedFrom);
+        } else {
+            memcpy(s->data, seed, seedSize);
+        }
+        dynfile.data = s->data;
+        dynfile.size = seedSize;
+        mangle_mangleContent(&run, speedFactor);
+        mangle_lastRoundChanges(&s->changed, &s->movedFrom);
+        s->size = dynfile.size;
+        s->gen  = gen;
+        __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    }
+    free(seed);
+    return NULL;
+}
+
+/*
+ * Starts 'cnt' workers (at most MUTPIPE_MAX_WORKERS) mutating inputs of up to 'cap' bytes, as set
+ * in 'global'
+ */
+static inline void mutpipe_init(mutpipe_t* p, size_t cnt, honggfuzz_t* global, size_t cap) {
+    memset(p, '\0', sizeof(*p));
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    p->cnt    = HF_MIN(cnt, MUTPIPE_MAX_WORKERS);
+    p->global = global;
+    p->cap    = cap;
+    p->seed   = util_Malloc(cap);
+
+    sigset_t all, old;
+    sigfillset(&all);
+    /* Signals are left to the threads of the fuzzer */
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    for (size_t i = 0; i < p->cnt; i++) {
+        mutpipe_ring_t* r = &p->rings[i];
+        r->pipe           = p;
+        for (size_t j = 0; j < MUTPIPE_DEPTH; j++) {
+            r->slots[j].data = util_Malloc(cap);
+        }
+        if (pthread_create(&r->thread, NULL, mutpipe_worker, r) != 0) {
+            LOG_F("pthread_create() failed");
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+/* Stops and joins the workers */
+static inline void mutpipe_destroy(mutpipe_t* p) {
+    pthread_mutex_lock(&p->mutex);
+    p->stop = true;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    for (size_t i = 0; i < p->cnt; i++) {
+        pthread_join(p->rings[i].thread, NULL);
+        for (size_t j = 0; j < MUTPIPE_DEPTH; j++) {
+            free(p->rings[i].slots[j].data);
+        }
+    }
+    free(p->seed);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mutex);
+}
+
+/*
+ * Mutants are made from 'size' bytes of 'data' from now on, with mangle_mangleContent(speedFactor),
+ * and those of the previous seed are dropped. The workers pick the operators as the scheduler of
+ * the calling thread does now
+ */
+static inline void mutpipe_setSeed(
+    mutpipe_t* p, const uint8_t* data, size_t size, int speedFactor) {
+    pthread_mutex_lock(&p->mutex);
+    memcpy(p->seed, data, size);
+    p->seedSize    = size;
+    p->speedFactor = speedFactor;
+    mangle_getSchedule(&p->sched);
+    __atomic_store_n(&p->gen, p->gen + 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+/* Gives the oldest slot of the ring back to its worker, waking it up if it waits for room */
+static inline void mutpipe_advance(mutpipe_t* p, mutpipe_ring_t* r) {
+    uint64_t tail = r->tail + 1;
+    __atomic_store_n(&r->tail, tail, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->sleeping, __ATOMIC_SEQ_CST) &&
+        (__atomic_load_n(&r->head, __ATOMIC_RELAXED) - tail) <= (MUTPIPE_DEPTH / 2)) {
+        pthread_mutex_lock(&p->mutex);
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->mutex);
+    }
+}
+
+/*
+ * A mutant of the current seed, valid until the next call, or NULL if none is ready. The slot
+ * handed out by the previous call is given back
+ */
+static inline const mutpipe_slot_t* mutpipe_pop(mutpipe_t* p) {
+    if (p->held) {
+        mutpipe_advance(p, p->held);
+        p->held = NULL;
+    }
+    uint64_t gen = __atomic_load_n(&p->gen, __ATOMIC_RELAXED);
+    for (size_t n = 0; n < p->cnt; n++) {
+        mutpipe_ring_t* r = &p->rings[p->next];
+        p->next           = (p->next + 1) % p->cnt;
+        uint64_t head     = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        while (r->tail != head) {
+            const mutpipe_slot_t* s = &r->slots[r->tail % MUTPIPE_DEPTH];
+            if (s->gen == gen) {
+                p->held = r;
+                return s;
+            }
+            /* Made from a previous seed */
+            mutpipe_advance(p, r);
+        }
+    }
+    return NULL;
+}
+
+#endif /* _HF_MUTPIPE_H_ */
@@ -0,0 +1,189 @@
+/*
+ * Honggfuzz+ - formatting and parsing of ASCII numbers, for the mangle operators
+ * -----------------------------------------
+ *
+ * Numbers are written straight into the input, in a field of the length chosen by the operator:
+ * left-justified, padded with spaces and cut after its first bytes, as the first 'len' bytes of
+ * snprintf("%-*" PRId64) were (decimal, signed, hexadecimal, octal), or right-justified and padded
+ * with zeros, keeping its last digits (fixed-width fields). Decimal digits are written two at a
+ * time from a table of the pairs, with one division by 100 for each, and the number of digits comes
+ * from the highest set bit and a table of the powers of 10.
+ *
+ * Decimal and hexadecimal digits are parsed 8 at a time within a 64-bit word (SWAR): the values of
+ * the digits are combined in pairs, then in quads and octets, with three multiplications or shifts.
+ */
+
+#ifndef _HF_NUMFMT_H_
+#define _HF_NUMFMT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const char numfmt_pairs[200] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char numfmt_xdigits[16] = "0123456789abcdef";
+
+static const uint64_t numfmt_pow10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL,
+    10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+    10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+/* Number of decimal digits of v */
+static inline size_t numfmt_decLen(uint64_t v) {
+    size_t t = ((64 - __builtin_clzll(v | 1)) * 1233) >> 12;
+    return t + 1 - ((v | 1) < numfmt_pow10[t]);
+}
+
+/* The 'n' (numfmt_decLen()) digits of v at out[0, n) */
+static inline void numfmt_decDigits(uint8_t* out, uint64_t v, size_t n) {
+    while (v >= 100) {
+        n -= 2;
+        memcpy(&out[n], &numfmt_pairs[(v % 100) * 2], 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        memcpy(out, &numfmt_pairs[v * 2], 2);
+    } else {
+        out[0] = '0' + v;
+    }
+}
+
+/* The 'n' digits of v in base 1 << 'bits' (hexadecimal or octal) at out[0, n) */
+static inline void numfmt_powDigits(uint8_t* out, uint64_t v, size_t n, unsigned bits) {
+    for (size_t i = n; i-- > 0;) {
+        out[i] = numfmt_xdigits[v & ((1U << bits) - 1)];
+        v >>= bits;
+    }
+}
+
+static inline void numfmt_pad(uint8_t* out, size_t from, size_t len) {
+    if (from < len) {
+        memset(&out[from], ' ', len - from);
+    }
+}
+
+/* v at out[0, len), left-justified */
+static inline void numfmt_dec(uint8_t* out, size_t len, uint64_t v) {
+    size_t n = numfmt_decLen(v);
+    if (n > len) {
+        if (len == 0) {
+            return;
+        }
+        v /= numfmt_pow10[n - len];
+        n = len;
+    }
+    numfmt_decDigits(out, v, n);
+    numfmt_pad(out, n, len);
+}
+
+static inline void numfmt_signed(uint8_t* out, size_t len, int64_t v) {
+    if (v >= 0) {
+        numfmt_dec(out, len, (uint64_t)v);
+        return;
+    }
+    if (len == 0) {
+        return;
+    }
+    out[0] = '-';
+    numfmt_dec(&out[1], len - 1, -(uint64_t)v);
+}
+
+static inline void numfmt_pow(uint8_t* out, size_t len, uint64_t v, unsigned bits) {
+    size_t n = (64 - __builtin_clzll(v | 1) + bits - 1) / bits;
+    if (n > len) {
+        if (len == 0) {
+            return;
+        }
+        v >>= (n - len) * bits;
+        n = len;
+    }
+    numfmt_powDigits(out, v, n, bits);
+    numfmt_pad(out, n, len);
+}
+
+static inline void numfmt_hex(uint8_t* out, size_t len, uint64_t v) {
+    numfmt_pow(out, len, v, 4);
+}
+
+static inline void numfmt_oct(uint8_t* out, size_t len, uint64_t v) {
+    numfmt_pow(out, len, v, 3);
+}
+
+/* v at out[0, len), right-justified with zeros, its last 'len' digits if it's longer */
+static inline void numfmt_zeroPad(uint8_t* out, size_t len, uint64_t v) {
+    if (len < 20) {
+        v %= numfmt_pow10[len];
+    }
+    size_t n = numfmt_decLen(v);
+    if (n > len) {
+        return;
+    }
+    memset(out, '0', len - n);
+    numfmt_decDigits(&out[len - n], v, n);
+}
+
+/* 'len' (1..8) digits at p, preceded by '0's up to 8, with the first one in the lowest byte */
+static inline uint64_t numfmt_load8(const uint8_t* p, size_t len) {
+    uint64_t w = 0x3030303030303030ULL;
+    memcpy((uint8_t*)&w + (8 - len), p, len);
+    return w;
+}
+
+/* Decimal value of 'len' digits, modulo 2^64 */
+static inline uint64_t numfmt_parseDec(const uint8_t* p, size_t len) {
+    uint64_t v = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (len > 0) {
+        size_t   n = (len % 8) ? (len % 8) : 8;
+        uint64_t w = numfmt_load8(p, n) - 0x3030303030303030ULL;
+        w          = (w * 10) + (w >> 8);
+        w          = (((w & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+                    (((w >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >>
+            32;
+        v = v * numfmt_pow10[n] + w;
+        p += n;
+        len -= n;
+    }
+#else
+    for (size_t i = 0; i < len; i++) {
+        v = v * 10 + (p[i] - '0');
+    }
+#endif /* __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ */
+    return v;
+}
+
+/* Hexadecimal value of 'len' digits, the last 16 if there are more */
+static inline uint64_t numfmt_parseHex(const uint8_t* p, size_t len) {
+    uint64_t v = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (len > 0) {
+        size_t   n = (len % 8) ? (len % 8) : 8;
+        uint64_t w = numfmt_load8(p, n);
+        /* '0'-'9' and 'a'-'f' (or 'A'-'F') to 0-15, the letters have bit 6 set */
+        w = (w & 0x0F0F0F0F0F0F0F0FULL) + ((w >> 6) & 0x0101010101010101ULL) * 9;
+        w = ((w << 4) | (w >> 8)) & 0x00FF00FF00FF00FFULL;
+        w = ((w << 8) | (w >> 16)) & 0x0000FFFF0000FFFFULL;
+        w = ((w << 16) | (w >> 32)) & 0x00000000FFFFFFFFULL;
+        v = (v << (n * 4)) | w;
+        p += n;
+        len -= n;
+    }
+#else
+    for (size_t i = 0; i < len; i++) {
+        v = (v << 4) | ((p[i] & 0x0F) + (p[i] >> 6) * 9);
+    }
+#endif /* __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ */
+    return v;
+}
+
+#endif /* _HF_NUMFMT_H_ */
@@ -0,0 +1,488 @@
+/*
+ * Honggfuzz+ - index of the ASCII numbers of an input, for mangle_ASCIINumChange
+ * -----------------------------------------
+ *
+ * Numbers are runs of decimal digits, with the '-' before them if there's one, and hexadecimal
+ * digits after "0x" or "0X". numidx_find() looks for the next byte which is (or isn't) a decimal
+ * digit 32 (AVX2) or 16 (SSE2) bytes at a time, and numidx_build() finds all of them from masks of
+ * the digits of 64 bytes.
+ *
+ * Rounds start from the same seed many times in a row, so the numbers are indexed once per seed:
+ * numidx_begin() recognizes the seed from its size and a few sampled words, and indexes it once
+ * NUMIDX_MIN_WANTED rounds from it asked for a number (numidx_want()). Within a round the index
+ * isn't changed, the edits are recorded instead (numidx_edit()): a number is looked up by replaying
+ * them over its offset, and is gone if one of them touched it. The bytes written by them are
+ * scanned again when a number is needed (numidx_refresh()), and the numbers found there are kept
+ * apart, in offsets of the current input. A number which isn't where the index says is dropped,
+ * and if it was one of the seed, so is the index: the input only looked like the seed, which
+ * happens when the caller doesn't restore it between rounds, so there's no index for the next
+ * NUMIDX_BACKOFF rounds.
+ */
+
+#ifndef _HF_NUMIDX_H_
+#define _HF_NUMIDX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+#include "memswap.h"
+#include "piecetab.h"
+#include "scratch.h"
+
+/* Edits of a round which are tracked, the index isn't used for the rest of the round after that */
+#define NUMIDX_MAX_EDITS 64U
+/* Bytes around an edit which are scanned again, for the numbers it extended */
+#define NUMIDX_CONTEXT 32U
+/* Rounds from the same seed which ask for a number before it's indexed */
+#define NUMIDX_MIN_WANTED 8U
+/* Rounds without an index after one was wrong, the input isn't restored between rounds */
+#define NUMIDX_BACKOFF 64U
+
+typedef enum {
+    NUMIDX_DEC = 0,
+    NUMIDX_NEG,
+    NUMIDX_HEX,
+} numidx_kind_t;
+
+/* Digits at [off, off + len), preceded by "-" (NUMIDX_NEG) or "0x" (NUMIDX_HEX) */
+typedef struct {
+    uint32_t off;
+    uint32_t len;
+    uint8_t  kind;
+} numidx_num_t;
+
+typedef enum {
+    NUMIDX_OVERWRITE = 0,
+    NUMIDX_INSERT,
+    NUMIDX_DELETE,
+} numidx_editKind_t;
+
+typedef struct {
+    uint8_t  kind;
+    uint32_t off;
+    uint32_t len;
+} numidx_edit_t;
+
+typedef struct {
+    numidx_num_t* nums; /* of the seed */
+    size_t        cnt;
+    size_t        cap;
+    uint64_t      seed;
+    uint32_t      wanted; /* rounds from this seed which asked for a number */
+    bool          valid;
+    uint32_t      backoff;
+    bool          active; /* edits of this round are tracked */
+    numidx_edit_t edits[NUMIDX_MAX_EDITS];
+    size_t        editCnt;
+    struct {
+        uint32_t lo;
+        uint32_t hi;
+    } dirty[NUMIDX_MAX_EDITS];
+    size_t        dirtyCnt;
+    numidx_num_t* added; /* found in the edited bytes */
+    size_t        addedCnt;
+    size_t        addedCap;
+} numidx_t;
+
+static inline bool numidx_isDigit(uint8_t c) {
+    return (uint8_t)(c - '0') < 10;
+}
+
+static inline bool numidx_isXDigit(uint8_t c) {
+    return numidx_isDigit(c) || (uint8_t)((c | 0x20) - 'a') < 6;
+}
+
+static inline size_t numidx_prefix(const numidx_num_t* n) {
+    return (n->kind == NUMIDX_HEX) ? 2 : (n->kind == NUMIDX_NEG) ? 1 : 0;
+}
+
+static inline size_t numidx_findScalar(const uint8_t* p, size_t len, bool digit) {
+    size_t i = 0;
+    while (i < len && numidx_isDigit(p[i]) != digit) {
+        i++;
+    }
+    return i;
+}
+
+#if defined(_HF_MEMSWAP_X86)
+HF_ATTR_SSE2 static size_t numidx_findSSE2(const uint8_t* p, size_t len, bool digit) {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const uint32_t flip = digit ? 0 : 0xFFFF;
+    size_t         i    = 0;
+    for (; (i + 16) <= len; i += 16) {
+        __m128i  v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)&p[i]), zero);
+        uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v)) ^ flip;
+        if (m) {
+            return i + __builtin_ctz(m);
+        }
+    }
+    return i + numidx_findScalar(&p[i], len - i, digit);
+}
+
+HF_ATTR_AVX2 static size_t numidx_findAVX2(const uint8_t* p, size_t len, bool digit) {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const uint32_t flip = digit ? 0 : UINT32_MAX;
+    size_t         i    = 0;
+    for (; (i + 32) <= len; i += 32) {
+        __m256i  v = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)&p[i]), zero);
+        uint32_t m =
+            (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, nine), v)) ^ flip;
+        if (m) {
+            return i + __builtin_ctz(m);
+        }
+    }
+    return i + numidx_findSSE2(&p[i], len - i, digit);
+}
+
+HF_ATTR_SSE2 static uint64_t numidx_maskSSE2(const uint8_t* p) {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    uint64_t      m    = 0;
+    for (size_t i = 0; i < 64; i += 16) {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)&p[i]), zero);
+        m |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v)) << i;
+    }
+    return m;
+}
+
+HF_ATTR_AVX2 static uint64_t numidx_maskAVX2(const uint8_t* p) {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    __m256i       lo   = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)p), zero);
+    __m256i       hi   = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)&p[32]), zero);
+    uint32_t      mlo  = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(lo, nine), lo));
+    uint32_t      mhi  = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(hi, nine), hi));
+    return ((uint64_t)mhi << 32) | mlo;
+}
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+/* Bit i set if p[i] is a decimal digit, for i < len (<= 64) */
+static uint64_t numidx_maskScalar(const uint8_t* p, size_t len) {
+    uint64_t m = 0;
+    for (size_t i = 0; i < len; i++) {
+        m |= (uint64_t)numidx_isDigit(p[i]) << i;
+    }
+    return m;
+}
+
+/* Offset of the first byte of p[0, len) which is a decimal digit (or isn't, !digit), or len */
+static inline size_t numidx_find(const uint8_t* p, size_t len, bool digit) {
+    /* Runs between numbers are usually short, don't bother with vectors for them */
+    if (len >= 16 && !(numidx_isDigit(p[0]) == digit)) {
+#if defined(_HF_MEMSWAP_X86)
+        if (__builtin_cpu_supports("avx2") && len >= 64) {
+            return numidx_findAVX2(p, len, digit);
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return numidx_findSSE2(p, len, digit);
+        }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    }
+    return numidx_findScalar(p, len, digit);
+}
+
+/* The first number in p[*pos, len), *pos is moved past it */
+static inline bool numidx_next(const uint8_t* p, size_t len, size_t* pos, numidx_num_t* n) {
+    size_t i = *pos + numidx_find(&p[*pos], len - *pos, /* digit= */ true);
+    if (i >= len) {
+        *pos = len;
+        return false;
+    }
+    size_t j = i + numidx_find(&p[i], len - i, /* digit= */ false);
+    if ((j - i) == 1 && p[i] == '0' && (j + 1) < len && (p[j] | 0x20) == 'x' &&
+        numidx_isXDigit(p[j + 1])) {
+        size_t k = j + 1;
+        while (k < len && numidx_isXDigit(p[k])) {
+            k++;
+        }
+        *n   = (numidx_num_t){.off = j + 1, .len = k - j - 1, .kind = NUMIDX_HEX};
+        *pos = k;
+        return true;
+    }
+    uint8_t kind = (i > 0 && p[i - 1] == '-') ? NUMIDX_NEG : NUMIDX_DEC;
+    *n           = (numidx_num_t){.off = i, .len = j - i, .kind = kind};
+    *pos         = j;
+    return true;
+}
+
+__attribute__((noinline, cold)) static void numidx_grow(numidx_num_t** nums, size_t* cap) {
+    *cap  = *cap ? *cap * 2 : 1024;
+    *nums = realloc(*nums, *cap * sizeof(**nums));
+    if (*nums == NULL) {
+        LOG_F("realloc(nmemb='%zu') failed", *cap);
+    }
+}
+
+/* Adds the number made of the digits at [lo, hi), returns where the next one can start */
+static inline size_t numidx_add(
+    numidx_t* x, const uint8_t* data, size_t size, size_t lo, size_t hi) {
+    if (x->cnt == x->cap) {
+        numidx_grow(&x->nums, &x->cap);
+    }
+    numidx_num_t* n = &x->nums[x->cnt++];
+    if ((hi - lo) == 1 && data[lo] == '0' && (hi + 1) < size && (data[hi] | 0x20) == 'x' &&
+        numidx_isXDigit(data[hi + 1])) {
+        size_t end = hi + 1;
+        while (end < size && numidx_isXDigit(data[end])) {
+            end++;
+        }
+        *n = (numidx_num_t){.off = hi + 1, .len = end - hi - 1, .kind = NUMIDX_HEX};
+        return end;
+    }
+    uint8_t kind = (lo > 0 && data[lo - 1] == '-') ? NUMIDX_NEG : NUMIDX_DEC;
+    *n           = (numidx_num_t){.off = lo, .len = hi - lo, .kind = kind};
+    return hi;
+}
+
+/*
+ * Finds the same numbers as numidx_next(), but from a bit mask of the digits of each 64 bytes: runs
+ * of digits begin and end where a bit differs from the one before it
+ */
+__attribute__((noinline)) static void numidx_build(numidx_t* x, const uint8_t* data, size_t size) {
+    uint64_t (*mask)(const uint8_t*) = NULL;
+#if defined(_HF_MEMSWAP_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        mask = numidx_maskAVX2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        mask = numidx_maskSSE2;
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+    x->cnt      = 0;
+    size_t next = 0;        /* past the last number, hexadecimal ones span several runs */
+    size_t lo   = SIZE_MAX; /* start of the current run */
+    for (size_t blk = 0; blk < size; blk += 64) {
+        size_t   len = HF_MIN(size - blk, 64);
+        uint64_t m   = (mask && len == 64) ? mask(&data[blk]) : numidx_maskScalar(&data[blk], len);
+        for (uint64_t edges = m ^ ((m << 1) | (lo != SIZE_MAX)); edges; edges &= edges - 1) {
+            size_t pos = blk + __builtin_ctzll(edges);
+            if (lo == SIZE_MAX) {
+                lo = pos;
+            } else {
+                if (lo >= next) {
+                    next = numidx_add(x, data, size, lo, pos);
+                }
+                lo = SIZE_MAX;
+            }
+        }
+    }
+    if (lo != SIZE_MAX && lo >= next) {
+        numidx_add(x, data, size, lo, size);
+    }
+    x->valid = true;
+}
+
+/* Size and 8 words spread over the input, enough to tell the seeds of consecutive rounds apart */
+static inline uint64_t numidx_seed(const uint8_t* data, size_t size) {
+    uint64_t h = (size + 1) * 0x9E3779B97F4A7C15ULL;
+    if (size < sizeof(uint64_t)) {
+        for (size_t i = 0; i < size; i++) {
+            h = (h ^ data[i]) * 0x100000001B3ULL;
+        }
+        return h;
+    }
+    for (size_t k = 0; k < 8; k++) {
+        uint64_t w;
+        memcpy(&w, &data[(size - sizeof(w)) * k / 7], sizeof(w));
+        h = (h ^ w) * 0x100000001B3ULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+/* Starts a round over the (flat) input */
+static inline void numidx_begin(numidx_t* x, const uint8_t* data, size_t size) {
+    uint64_t seed = numidx_seed(data, size);
+    if (seed != x->seed) {
+        x->seed   = seed;
+        x->wanted = 0;
+        x->valid  = false;
+    }
+    if (x->backoff > 0) {
+        x->backoff--;
+    }
+    if (x->wanted >= NUMIDX_MIN_WANTED && !x->valid && x->backoff == 0 && size <= UINT32_MAX) {
+        numidx_build(x, data, size);
+    }
+    x->active   = x->valid;
+    x->editCnt  = 0;
+    x->dirtyCnt = 0;
+    x->addedCnt = 0;
+}
+
+/* A number was asked for, the seed is worth indexing */
+static inline void numidx_want(numidx_t* x) {
+    x->wanted++;
+}
+
+/* Moves 'n' as 'e' does, false if 'e' touched it */
+static inline bool numidx_track(const numidx_edit_t* e, numidx_num_t* n) {
+    size_t lo = n->off - numidx_prefix(n);
+    size_t hi = (size_t)n->off + n->len;
+    switch (e->kind) {
+        case NUMIDX_OVERWRITE:
+            return (e->off > hi || ((size_t)e->off + e->len) < lo);
+        case NUMIDX_INSERT:
+            if (e->off < lo) {
+                n->off += e->len;
+                return true;
+            }
+            return e->off > hi;
+        case NUMIDX_DELETE:
+            if (((size_t)e->off + e->len) < lo) {
+                n->off -= e->len;
+                return true;
+            }
+            return e->off > hi;
+        default:
+            return false;
+    }
+}
+
+/* Bytes [off, off + len) were overwritten, inserted or deleted */
+static inline void numidx_edit(numidx_t* x, numidx_editKind_t kind, size_t off, size_t len) {
+    if (!x->active) {
+        return;
+    }
+    if (x->editCnt == NUMIDX_MAX_EDITS) {
+        x->active = false;
+        return;
+    }
+    numidx_edit_t* e = &x->edits[x->editCnt++];
+    *e               = (numidx_edit_t){.kind = kind, .off = off, .len = len};
+
+    for (size_t i = 0; i < x->addedCnt;) {
+        if (numidx_track(e, &x->added[i])) {
+            i++;
+        } else {
+            x->added[i] = x->added[--x->addedCnt];
+        }
+    }
+    for (size_t i = 0; i < x->dirtyCnt; i++) {
+        uint32_t* lo = &x->dirty[i].lo;
+        uint32_t* hi = &x->dirty[i].hi;
+        if (kind == NUMIDX_INSERT) {
+            *lo += (off < *lo) ? len : 0;
+            *hi += (off <= *hi) ? len : 0;
+        } else if (kind == NUMIDX_DELETE) {
+            *lo = (*lo < off) ? *lo : (*lo < off + len) ? off : *lo - len;
+            *hi = (*hi < off) ? *hi : (*hi < off + len) ? off : *hi - len;
+        }
+    }
+    size_t hi = (kind == NUMIDX_DELETE) ? off : off + len;
+    x->dirty[x->dirtyCnt].lo = off;
+    x->dirty[x->dirtyCnt].hi = hi;
+    x->dirtyCnt++;
+}
+
+/* Indexes the numbers touching the bytes edited since the last call */
+static inline void numidx_refresh(numidx_t* x, const piecetab_t* t) {
+    if (x->dirtyCnt == 0) {
+        return;
+    }
+    /* Sorted and merged, so that no number is found twice */
+    for (size_t d = 1; d < x->dirtyCnt; d++) {
+        __typeof__(x->dirty[0]) r = x->dirty[d];
+        size_t                  i = d;
+        for (; i > 0 && x->dirty[i - 1].lo > r.lo; i--) {
+            x->dirty[i] = x->dirty[i - 1];
+        }
+        x->dirty[i] = r;
+    }
+    size_t cnt  = x->dirtyCnt;
+    x->dirtyCnt = 1;
+    for (size_t d = 1; d < cnt; d++) {
+        if (x->dirty[d].lo <= x->dirty[x->dirtyCnt - 1].hi) {
+            x->dirty[x->dirtyCnt - 1].hi = HF_MAX(x->dirty[x->dirtyCnt - 1].hi, x->dirty[d].hi);
+        } else {
+            x->dirty[x->dirtyCnt++] = x->dirty[d];
+        }
+    }
+    for (size_t d = 0; d < x->dirtyCnt; d++) {
+        for (size_t i = 0; i < x->addedCnt;) {
+            const numidx_num_t* a = &x->added[i];
+            if ((a->off - numidx_prefix(a)) <= x->dirty[d].hi &&
+                x->dirty[d].lo <= (a->off + a->len)) {
+                x->added[i] = x->added[--x->addedCnt];
+            } else {
+                i++;
+            }
+        }
+    }
+
+    for (size_t d = 0; d < x->dirtyCnt; d++) {
+        size_t lo  = x->dirty[d].lo;
+        size_t hi  = x->dirty[d].hi;
+        size_t beg = (lo > NUMIDX_CONTEXT) ? lo - NUMIDX_CONTEXT : 0;
+        size_t end = HF_MIN(hi + NUMIDX_CONTEXT, t->size);
+        if (beg >= end) {
+            continue;
+        }
+
+        size_t         mark = scratch_mark();
+        size_t         segLen;
+        const uint8_t* p = piecetab_segment(t, beg, &segLen);
+        if (segLen < (end - beg)) {
+            uint8_t* buf = scratch_alloc(end - beg);
+            piecetab_read(t, beg, buf, end - beg);
+            p = buf;
+        }
+        numidx_num_t n;
+        for (size_t pos = 0; numidx_next(p, end - beg, &pos, &n);) {
+            n.off += beg;
+            if ((n.off - numidx_prefix(&n)) > hi || (n.off + n.len) < lo) {
+                continue;
+            }
+            /* Touching the previous edited range too */
+            if (x->addedCnt > 0 && x->added[x->addedCnt - 1].off == n.off) {
+                continue;
+            }
+            if (x->addedCnt == x->addedCap) {
+                numidx_grow(&x->added, &x->addedCap);
+            }
+            x->added[x->addedCnt++] = n;
+        }
+        scratch_release(mark);
+    }
+    x->dirtyCnt = 0;
+}
+
+/* Numbers which can be asked for with numidx_get(), 0 if the index isn't in use */
+static inline size_t numidx_cnt(const numidx_t* x) {
+    return x->active ? x->cnt + x->addedCnt : 0;
+}
+
+/* Number 'i' (< numidx_cnt()) in offsets of the current input, false if it was edited */
+static inline bool numidx_get(const numidx_t* x, size_t i, numidx_num_t* n) {
+    if (i >= x->cnt) {
+        *n = x->added[i - x->cnt];
+        return true;
+    }
+    *n = x->nums[i];
+    for (size_t e = 0; e < x->editCnt; e++) {
+        if (!numidx_track(&x->edits[e], n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Number 'i' isn't where numidx_get() said */
+static inline void numidx_drop(numidx_t* x, size_t i) {
+    if (i >= x->cnt) {
+        x->added[i - x->cnt] = x->added[--x->addedCnt];
+        return;
+    }
+    x->valid   = false;
+    x->active  = false;
+    x->backoff = NUMIDX_BACKOFF;
+}
+
+#endif /* _HF_NUMIDX_H_ */
@@ -0,0 +1,232 @@
+/*
+ * Honggfuzz+ - adaptive scheduler for the mangle operators
+ * -----------------------------------------
+ *
+ * Each operator is weighted by how many new corpus entries it was credited with, per nanosecond
+ * spent on it. The time charged to a round is the wall time from its start to the start of the
+ * next round, so it includes running the target with the resulting input, and is split between
+ * the operators used in that round, as is the credit for a new corpus entry. A fixed share of the
+ * probability mass is spread uniformly, so that no operator is starved.
+ *
+ * Picking an operator costs one random draw and one lookup in a Vose alias table, which is rebuilt
+ * from the weights when new credit arrives and periodically as the costs change.
+ */
+
+#ifndef _HF_OPSCHED_H_
+#define _HF_OPSCHED_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define OPSCHED_MAX_OPS 32U
+/* Share of picks made uniformly among all operators */
+#define OPSCHED_EXPLORE 0.1
+/* Every operator starts with 1 find per 10ms, so that the first weights are uniform */
+#define OPSCHED_PRIOR_FINDS 1.0
+#define OPSCHED_PRIOR_NS    10000000.0
+/* Rounds between rebuilds of the alias table without new credit */
+#define OPSCHED_REBUILD_ROUNDS 256U
+/* Rounds after which the history is halved, to follow the campaign as it progresses */
+#define OPSCHED_DECAY_ROUNDS (1U << 16)
+/* Longer gaps between rounds (e.g. calibration, sync, UI) aren't charged to the operators */
+#define OPSCHED_MAX_ROUND_NS 1000000000ULL
+
+typedef struct {
+    double   finds;
+    double   spentNs;
+    uint32_t roundUses;
+} opsched_op_t;
+
+typedef struct {
+    size_t       cnt;
+    uint32_t     prob[OPSCHED_MAX_OPS];
+    uint8_t      alias[OPSCHED_MAX_OPS];
+    opsched_op_t op[OPSCHED_MAX_OPS];
+    uint32_t     roundUses;
+    uint64_t     roundStartNs;
+    uint64_t     rounds;
+    bool         dirty;
+} opsched_t;
+
+static inline uint64_t opsched_nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Vose's alias method: O(cnt) construction, O(1) sampling */
+static inline void opsched_rebuild(opsched_t* s) {
+    double effSum = 0.0;
+    double eff[OPSCHED_MAX_OPS];
+    for (size_t i = 0; i < s->cnt; i++) {
+        eff[i] = (s->op[i].finds + OPSCHED_PRIOR_FINDS) / (s->op[i].spentNs + OPSCHED_PRIOR_NS);
+        effSum += eff[i];
+    }
+
+    double  scaled[OPSCHED_MAX_OPS];
+    uint8_t small[OPSCHED_MAX_OPS], large[OPSCHED_MAX_OPS];
+    size_t  smallCnt = 0, largeCnt = 0;
+    for (size_t i = 0; i < s->cnt; i++) {
+        double w  = (OPSCHED_EXPLORE / s->cnt) + (1.0 - OPSCHED_EXPLORE) * (eff[i] / effSum);
+        scaled[i] = w * s->cnt;
+        if (scaled[i] < 1.0) {
+            small[smallCnt++] = (uint8_t)i;
+        } else {
+            large[largeCnt++] = (uint8_t)i;
+        }
+    }
+    while (smallCnt > 0 && largeCnt > 0) {
+        uint8_t l   = small[--smallCnt];
+        uint8_t g   = large[largeCnt - 1];
+        s->prob[l]  = (uint32_t)(scaled[l] * 4294967296.0);
+        s->alias[l] = g;
+        scaled[g] -= (1.0 - scaled[l]);
+        if (scaled[g] < 1.0) {
+            largeCnt--;
+            small[smallCnt++] = g;
+        }
+    }
+    /* Whatever is left is at 1.0 (modulo rounding errors) */
+    while (largeCnt > 0) {
+        uint8_t g   = large[--largeCnt];
+        s->prob[g]  = UINT32_MAX;
+        s->alias[g] = g;
+    }
+    while (smallCnt > 0) {
+        uint8_t l   = small[--smallCnt];
+        s->prob[l]  = UINT32_MAX;
+        s->alias[l] = l;
+    }
+    s->dirty = false;
+}
+
+static inline void opsched_init(opsched_t* s, size_t cnt) {
+    memset(s, '\0', sizeof(*s));
+    s->cnt = cnt;
+    opsched_rebuild(s);
+}
+
+/* The upper 32 bits of 'rnd' pick the column, the lower 32 bits decide between it and its alias */
+static inline size_t opsched_pick(const opsched_t* s, uint64_t rnd) {
+    size_t col = (size_t)(((rnd >> 32) * s->cnt) >> 32);
+    return ((uint32_t)rnd < s->prob[col]) ? col : s->alias[col];
+}
+
+static inline void opsched_use(opsched_t* s, size_t op) {
+    s->op[op].roundUses++;
+    s->roundUses++;
+}
+
+/* Charges 'ns' to the operators used in the current round */
+static inline void opsched_charge(opsched_t* s, uint64_t ns) {
+    if (s->roundUses == 0 || ns >= OPSCHED_MAX_ROUND_NS) {
+        return;
+    }
+    double perUse = (double)ns / s->roundUses;
+    for (size_t i = 0; i < s->cnt; i++) {
+        s->op[i].spentNs += perUse * s->op[i].roundUses;
+    }
+}
+
+/* Charges the time since the current round started to its operators, and forgets them */
+static inline void opsched_endRound(opsched_t* s, uint64_t now) {
+    if (s->roundStartNs > 0) {
+        opsched_charge(s, now - s->roundStartNs);
+    }
+    for (size_t i = 0; i < s->cnt; i++) {
+        s->op[i].roundUses = 0;
+    }
+    s->roundUses = 0;
+}
+
+/* Charges the time since the previous round started to its operators, and starts a new round */
+static inline void opsched_newRound(opsched_t* s) {
+    uint64_t now = opsched_nowNs();
+    opsched_endRound(s, now);
+    s->roundStartNs = now;
+
+    s->rounds++;
+    if ((s->rounds % OPSCHED_DECAY_ROUNDS) == 0) {
+        for (size_t i = 0; i < s->cnt; i++) {
+            s->op[i].finds /= 2.0;
+            s->op[i].spentNs /= 2.0;
+        }
+    }
+    if (s->dirty || (s->rounds % OPSCHED_REBUILD_ROUNDS) == 0) {
+        opsched_rebuild(s);
+    }
+}
+
+/*
+ * Rounds made ahead of their execution (mangle_mangleBatch()) are charged and credited when they
+ * run. opsched_saveRound() takes the current round out, with the time spent on it so far.
+ * opsched_runRound() charges a saved round that time, and makes it the current round again, so that
+ * the time until the next round, and a credit, go to it
+ */
+typedef struct {
+    uint32_t uses[OPSCHED_MAX_OPS];
+    uint32_t total;
+    uint64_t ns;
+} opsched_round_t;
+
+static inline void opsched_saveRound(opsched_t* s, opsched_round_t* r) {
+    r->ns    = (s->roundStartNs > 0) ? (opsched_nowNs() - s->roundStartNs) : 0;
+    r->total = s->roundUses;
+    for (size_t i = 0; i < s->cnt; i++) {
+        r->uses[i]         = s->op[i].roundUses;
+        s->op[i].roundUses = 0;
+    }
+    s->roundUses    = 0;
+    s->roundStartNs = 0;
+}
+
+static inline void opsched_runRound(opsched_t* s, const opsched_round_t* r) {
+    uint64_t now = opsched_nowNs();
+    opsched_endRound(s, now);
+    for (size_t i = 0; i < s->cnt; i++) {
+        s->op[i].roundUses = r->uses[i];
+    }
+    s->roundUses = r->total;
+    opsched_charge(s, r->ns);
+    s->roundStartNs = now;
+}
+
+/* The picks of a scheduler, for threads which pick as it does, without learning */
+typedef struct {
+    size_t   cnt;
+    uint32_t prob[OPSCHED_MAX_OPS];
+    uint8_t  alias[OPSCHED_MAX_OPS];
+} opsched_table_t;
+
+static inline void opsched_getTable(opsched_t* s, opsched_table_t* t) {
+    if (s->dirty) {
+        opsched_rebuild(s);
+    }
+    t->cnt = s->cnt;
+    memcpy(t->prob, s->prob, sizeof(t->prob));
+    memcpy(t->alias, s->alias, sizeof(t->alias));
+}
+
+/* 's' picks from 't', it mustn't be charged or credited, as that would rebuild it */
+static inline void opsched_setTable(opsched_t* s, const opsched_table_t* t) {
+    memset(s, '\0', sizeof(*s));
+    s->cnt = t->cnt;
+    memcpy(s->prob, t->prob, sizeof(s->prob));
+    memcpy(s->alias, t->alias, sizeof(s->alias));
+}
+
+/* The input produced by the current round was added to the corpus */
+static inline void opsched_credit(opsched_t* s) {
+    if (s->roundUses == 0) {
+        return;
+    }
+    for (size_t i = 0; i < s->cnt; i++) {
+        s->op[i].finds += (double)s->op[i].roundUses / s->roundUses;
+    }
+    s->dirty = true;
+}
+
+#endif /* _HF_OPSCHED_H_ */
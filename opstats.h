@@ -0,0 +1,257 @@
+/*
+ * Honggfuzz+ - per-operator counters for the mangle operators
+ * -----------------------------------------
+ *
+ * For every operator: number of calls, cycles spent (total, and a log2 histogram), number of
+ * rounds it took part in which produced a new corpus entry, and - for a 1/OPSTATS_SAMPLE_RATE
+ * sample of the calls on inputs of up to OPSTATS_SAMPLE_MAX_SZ bytes - how many bytes it changed
+ * and how many calls didn't change anything.
+ *
+ * Counters are per-thread and padded to cache lines, so the hot path only writes to memory owned
+ * by the calling thread. The blocks of all threads are summed up when the stats file is written.
+ */
+
+#ifndef _HF_OPSTATS_H_
+#define _HF_OPSTATS_H_
+
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif /* defined(__x86_64__) || defined(__i386__) */
+
+#define OPSTATS_MAX_OPS       32U
+#define OPSTATS_HIST_BUCKETS  24U
+#define OPSTATS_SAMPLE_RATE   64U
+#define OPSTATS_SAMPLE_MAX_SZ (64U * 1024U)
+#define OPSTATS_FLUSH_SECS    5
+
+typedef struct {
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t finds;
+    uint64_t sampled;
+    uint64_t sampledNoop;
+    uint64_t sampledBytes;
+    uint64_t hist[OPSTATS_HIST_BUCKETS];
+} __attribute__((aligned(64))) opstats_op_t;
+
+typedef struct opstats_thread {
+    opstats_op_t           op[OPSTATS_MAX_OPS];
+    uint64_t               roundOps;
+    struct opstats_thread* next;
+} opstats_thread_t;
+
+typedef struct {
+    size_t   op;
+    uint64_t start;
+    size_t   size;
+    bool     sampled;
+} opstats_call_t;
+
+static opstats_thread_t*          opstats_threads   = NULL;
+static char*                      opstats_path      = NULL;
+static time_t                     opstats_nextFlush = 0;
+static __thread opstats_thread_t* opstats_self      = NULL;
+static __thread uint8_t*          opstats_snapshot  = NULL;
+/* Frees the snapshot buffer of exiting threads, their counters are kept */
+static pthread_key_t  opstats_snapshotKey;
+static pthread_once_t opstats_snapshotOnce = PTHREAD_ONCE_INIT;
+
+static void opstats_snapshotInit(void) {
+    pthread_key_create(&opstats_snapshotKey, free);
+}
+
+static inline uint64_t opstats_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif /* defined(__x86_64__) || defined(__i386__) */
+}
+
+/* Counters are only kept if there's a file to write them to */
+static inline bool opstats_enabled(void) {
+    return __atomic_load_n(&opstats_path, __ATOMIC_RELAXED) != NULL;
+}
+
+static inline opstats_thread_t* opstats_thread(void) {
+    if (opstats_self) {
+        return opstats_self;
+    }
+    opstats_thread_t* t;
+    if (posix_memalign((void**)&t, 64, sizeof(*t)) != 0) {
+        return NULL;
+    }
+    memset(t, '\0', sizeof(*t));
+    opstats_snapshot = (uint8_t*)malloc(OPSTATS_SAMPLE_MAX_SZ);
+    pthread_once(&opstats_snapshotOnce, opstats_snapshotInit);
+    pthread_setspecific(opstats_snapshotKey, opstats_snapshot);
+
+    t->next = __atomic_load_n(&opstats_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(
+        &opstats_threads, &t->next, t, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    opstats_self = t;
+    return t;
+}
+
+/* Whether the next call of 'op' will compare the input before and after */
+static inline bool opstats_willSample(size_t op, size_t size) {
+    opstats_thread_t* t = opstats_thread();
+    return t && opstats_snapshot && (size <= OPSTATS_SAMPLE_MAX_SZ) &&
+           (t->op[op].calls % OPSTATS_SAMPLE_RATE) == 0;
+}
+
+static inline void opstats_begin(opstats_call_t* c, size_t op, const uint8_t* data, size_t size) {
+    c->op      = op;
+    c->size    = size;
+    c->sampled = opstats_willSample(op, size);
+    if (c->sampled) {
+        memcpy(opstats_snapshot, data, size);
+    }
+    c->start = opstats_cycles();
+}
+
+static inline void opstats_end(const opstats_call_t* c, const uint8_t* data, size_t size) {
+    uint64_t          cycles = opstats_cycles() - c->start;
+    opstats_thread_t* t      = opstats_self;
+    if (!t) {
+        return;
+    }
+    opstats_op_t* o = &t->op[c->op];
+    o->calls++;
+    o->cycles += cycles;
+    unsigned bucket = cycles ? (63U - (unsigned)__builtin_clzll(cycles)) : 0U;
+    o->hist[bucket < OPSTATS_HIST_BUCKETS ? bucket : (OPSTATS_HIST_BUCKETS - 1)]++;
+    t->roundOps |= (1ULL << c->op);
+
+    if (c->sampled) {
+        size_t common = (size < c->size) ? size : c->size;
+        size_t bytes  = (size > c->size) ? (size - c->size) : (c->size - size);
+        for (size_t i = 0; i < common; i++) {
+            bytes += (data[i] != opstats_snapshot[i]);
+        }
+        o->sampled++;
+        o->sampledBytes += bytes;
+        o->sampledNoop += (bytes == 0);
+    }
+}
+
+static inline void opstats_newRound(void) {
+    if (opstats_self) {
+        opstats_self->roundOps = 0;
+    }
+}
+
+/* Takes the operators of the current round out, for opstats_runRound() to credit them later */
+static inline uint64_t opstats_saveRound(void) {
+    opstats_thread_t* t = opstats_self;
+    if (!t) {
+        return 0;
+    }
+    uint64_t ops = t->roundOps;
+    t->roundOps  = 0;
+    return ops;
+}
+
+static inline void opstats_runRound(uint64_t ops) {
+    if (opstats_self) {
+        opstats_self->roundOps = ops;
+    }
+}
+
+/* The output of the current round was added to the corpus */
+static inline void opstats_credit(void) {
+    opstats_thread_t* t = opstats_self;
+    if (!t) {
+        return;
+    }
+    for (uint64_t ops = t->roundOps; ops; ops &= (ops - 1)) {
+        t->op[__builtin_ctzll(ops)].finds++;
+    }
+}
+
+/*
+ * One line per operator, space-separated, preceded by a '#' line naming the columns:
+ * name calls cycles finds sampled sampled_noop sampled_bytes hist_0 .. hist_N (hist_i counts
+ * calls which took [2^i, 2^(i+1)) cycles). Written to a temporary file first, and renamed, so
+ * readers never see a partial file.
+ */
+static inline void opstats_write(const char* const* names, size_t cnt, const char* comment) {
+    const char* path = __atomic_load_n(&opstats_path, __ATOMIC_ACQUIRE);
+    if (path == NULL) {
+        return;
+    }
+    opstats_op_t sum[OPSTATS_MAX_OPS];
+    memset(sum, '\0', sizeof(sum));
+    for (opstats_thread_t* t = __atomic_load_n(&opstats_threads, __ATOMIC_ACQUIRE); t;
+         t                   = t->next) {
+        for (size_t i = 0; i < cnt; i++) {
+            const opstats_op_t* o = &t->op[i];
+            sum[i].calls += __atomic_load_n(&o->calls, __ATOMIC_RELAXED);
+            sum[i].cycles += __atomic_load_n(&o->cycles, __ATOMIC_RELAXED);
+            sum[i].finds += __atomic_load_n(&o->finds, __ATOMIC_RELAXED);
+            sum[i].sampled += __atomic_load_n(&o->sampled, __ATOMIC_RELAXED);
+            sum[i].sampledNoop += __atomic_load_n(&o->sampledNoop, __ATOMIC_RELAXED);
+            sum[i].sampledBytes += __atomic_load_n(&o->sampledBytes, __ATOMIC_RELAXED);
+            for (size_t b = 0; b < OPSTATS_HIST_BUCKETS; b++) {
+                sum[i].hist[b] += __atomic_load_n(&o->hist[b], __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    char tmpPath[PATH_MAX];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* f = fopen(tmpPath, "w");
+    if (f == NULL) {
+        return;
+    }
+    fprintf(f, "# last_update %lld %s\n", (long long)time(NULL), comment);
+    fprintf(f, "# name calls cycles finds sampled sampled_noop sampled_bytes");
+    for (size_t b = 0; b < OPSTATS_HIST_BUCKETS; b++) {
+        fprintf(f, " hist_%zu", b);
+    }
+    fprintf(f, "\n");
+    for (size_t i = 0; i < cnt; i++) {
+        fprintf(f, "%s %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64,
+            names[i], sum[i].calls, sum[i].cycles, sum[i].finds, sum[i].sampled,
+            sum[i].sampledNoop, sum[i].sampledBytes);
+        for (size_t b = 0; b < OPSTATS_HIST_BUCKETS; b++) {
+            fprintf(f, " %" PRIu64, sum[i].hist[b]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    rename(tmpPath, path);
+}
+
+/* Only one thread writes the file per period */
+static inline bool opstats_flushDue(time_t now) {
+    time_t next = __atomic_load_n(&opstats_nextFlush, __ATOMIC_RELAXED);
+    if (now < next) {
+        return false;
+    }
+    return __atomic_compare_exchange_n(
+        &opstats_nextFlush, &next, now + OPSTATS_FLUSH_SECS, false, __ATOMIC_RELAXED,
+        __ATOMIC_RELAXED);
+}
+
+static inline void opstats_setPath(const char* path) {
+    char* newPath = path ? strdup(path) : NULL;
+    /* The old path is leaked on purpose, a concurrent opstats_write() might still be using it */
+    __atomic_store_n(&opstats_path, newPath, __ATOMIC_RELEASE);
+}
+
+#endif /* _HF_OPSTATS_H_ */
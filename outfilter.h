@@ -0,0 +1,317 @@
+/*
+ * Honggfuzz+ - filter of the recent outputs of the mutator, for exact duplicates
+ * -----------------------------------------
+ *
+ * An output which is byte-for-byte one of the last few the thread produced (or its parent) would
+ * only run the target again for nothing. Outputs are hashed with XXH3-64 (seed 0, default secret,
+ * the same values as XXH3_64bits() of xxHash 0.8), and the hashes kept in a direct-mapped table of
+ * OUTFILTER_SLOTS entries, where a new hash replaces the one in its slot: recent outputs are
+ * remembered, older ones fade out as their slots are reused. Two outputs with the same hash are
+ * taken as the same, which for 64-bit hashes and a few thousand of them is close enough. The hash
+ * of an output can be combined (outfilter_combine()) from that of its parent and of the bytes which
+ * differ, so that it costs no more than those.
+ */
+
+#ifndef _HF_OUTFILTER_H_
+#define _HF_OUTFILTER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libhfcommon/common.h"
+#include "memswap.h"
+
+#define OUTFILTER_BITS  12U
+#define OUTFILTER_SLOTS (1U << OUTFILTER_BITS)
+
+#define OUTFILTER_P32_1 0x9E3779B1U
+#define OUTFILTER_P32_2 0x85EBCA77U
+#define OUTFILTER_P32_3 0xC2B2AE3DU
+#define OUTFILTER_P64_1 0x9E3779B185EBCA87ULL
+#define OUTFILTER_P64_2 0xC2B2AE3D27D4EB4FULL
+#define OUTFILTER_P64_3 0x165667B19E3779F9ULL
+#define OUTFILTER_P64_4 0x85EBCA77C2B2AE63ULL
+#define OUTFILTER_P64_5 0x27D4EB2F165667C5ULL
+#define OUTFILTER_MX1   0x165667919E3779F9ULL
+#define OUTFILTER_MX2   0x9FB21C651E98DF25ULL
+
+/* Bytes hashed per stripe and per block of the long-input loop, for the 192-byte secret */
+#define OUTFILTER_STRIPE 64U
+#define OUTFILTER_BLOCK  1024U
+
+/* The default secret of XXH3 */
+static const uint8_t outfilter_secret[192] __attribute__((aligned(64))) = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+typedef struct {
+    uint64_t hashes[OUTFILTER_SLOTS]; /* 0: empty */
+} outfilter_t;
+
+static inline uint64_t outfilter_read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t outfilter_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t outfilter_rotl(uint64_t v, unsigned r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint64_t outfilter_mulFold(uint64_t a, uint64_t b) {
+    unsigned __int128 p = (unsigned __int128)a * b;
+    return (uint64_t)p ^ (uint64_t)(p >> 64);
+}
+
+static inline uint64_t outfilter_avalanche64(uint64_t h) {
+    h ^= h >> 33;
+    h *= OUTFILTER_P64_2;
+    h ^= h >> 29;
+    h *= OUTFILTER_P64_3;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t outfilter_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= OUTFILTER_MX1;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t outfilter_rrmxmx(uint64_t h, size_t len) {
+    h ^= outfilter_rotl(h, 49) ^ outfilter_rotl(h, 24);
+    h *= OUTFILTER_MX2;
+    h ^= (h >> 35) + len;
+    h *= OUTFILTER_MX2;
+    return h ^ (h >> 28);
+}
+
+static inline uint64_t outfilter_mix16(const uint8_t* p, const uint8_t* s) {
+    return outfilter_mulFold(outfilter_read64(p) ^ outfilter_read64(s),
+        outfilter_read64(p + 8) ^ outfilter_read64(s + 8));
+}
+
+static inline uint64_t outfilter_hash16(const uint8_t* p, size_t len) {
+    const uint8_t* s = outfilter_secret;
+    if (len > 8) {
+        uint64_t lo = outfilter_read64(p) ^ (outfilter_read64(s + 24) ^ outfilter_read64(s + 32));
+        uint64_t hi =
+            outfilter_read64(p + len - 8) ^ (outfilter_read64(s + 40) ^ outfilter_read64(s + 48));
+        return outfilter_avalanche(len + __builtin_bswap64(lo) + hi + outfilter_mulFold(lo, hi));
+    }
+    if (len >= 4) {
+        uint64_t v = outfilter_read32(p + len - 4) + ((uint64_t)outfilter_read32(p) << 32);
+        return outfilter_rrmxmx(v ^ (outfilter_read64(s + 8) ^ outfilter_read64(s + 16)), len);
+    }
+    if (len > 0) {
+        uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] |
+                     ((uint32_t)len << 8);
+        return outfilter_avalanche64(v ^ (outfilter_read32(s) ^ outfilter_read32(s + 4)));
+    }
+    return outfilter_avalanche64(outfilter_read64(s + 56) ^ outfilter_read64(s + 64));
+}
+
+static inline uint64_t outfilter_hash240(const uint8_t* p, size_t len) {
+    const uint8_t* s   = outfilter_secret;
+    uint64_t       acc = len * OUTFILTER_P64_1;
+    if (len <= 128) {
+        /* Pairs of 16 bytes from both ends, as many as it takes to cover the input */
+        for (size_t i = 0; i < 4 && (i * 32) < len; i++) {
+            acc += outfilter_mix16(p + i * 16, s + i * 32);
+            acc += outfilter_mix16(p + len - 16 * (i + 1), s + i * 32 + 16);
+        }
+        return outfilter_avalanche(acc);
+    }
+    for (size_t i = 0; i < 8; i++) {
+        acc += outfilter_mix16(p + i * 16, s + i * 16);
+    }
+    acc = outfilter_avalanche(acc);
+    for (size_t i = 8; i < len / 16; i++) {
+        acc += outfilter_mix16(p + i * 16, s + (i - 8) * 16 + 3);
+    }
+    acc += outfilter_mix16(p + len - 16, s + 136 - 17);
+    return outfilter_avalanche(acc);
+}
+
+/*
+ * The loop of the long inputs: stripes of 64 bytes are accumulated into 8 lanes, with the secret
+ * advancing by 8 bytes per stripe, the lanes are scrambled after each block of 16 stripes, and the
+ * last 64 bytes are accumulated once more. 'stripe' and 'scramble' are those of a kernel
+ */
+#define OUTFILTER_PER_BLOCK ((sizeof(outfilter_secret) - OUTFILTER_STRIPE) / 8)
+#define OUTFILTER_LOOP(acc, p, len, stripe, scramble)                                              \
+    do {                                                                                           \
+        const uint8_t* s_      = outfilter_secret;                                                 \
+        const uint8_t* last_   = s_ + sizeof(outfilter_secret) - OUTFILTER_STRIPE;                 \
+        size_t         blocks_ = ((len) - 1) / OUTFILTER_BLOCK;                                    \
+        for (size_t b_ = 0; b_ < blocks_; b_++) {                                                  \
+            for (size_t n_ = 0; n_ < OUTFILTER_PER_BLOCK; n_++) {                                  \
+                stripe(acc, (p) + b_ * OUTFILTER_BLOCK + n_ * OUTFILTER_STRIPE, s_ + n_ * 8);      \
+            }                                                                                      \
+            scramble(acc, last_);                                                                  \
+        }                                                                                          \
+        size_t tail_ = blocks_ * OUTFILTER_BLOCK;                                                  \
+        for (size_t n_ = 0; n_ < ((len) - 1 - tail_) / OUTFILTER_STRIPE; n_++) {                   \
+            stripe(acc, (p) + tail_ + n_ * OUTFILTER_STRIPE, s_ + n_ * 8);                         \
+        }                                                                                          \
+        stripe(acc, (p) + (len) - OUTFILTER_STRIPE, last_ - 7);                                    \
+    } while (0)
+
+static inline void outfilter_stripeScalar(uint64_t acc[8], const uint8_t* p, const uint8_t* s) {
+    for (size_t i = 0; i < 8; i++) {
+        uint64_t v   = outfilter_read64(p + i * 8);
+        uint64_t key = v ^ outfilter_read64(s + i * 8);
+        acc[i ^ 1] += v;
+        acc[i] += (key & 0xFFFFFFFFU) * (key >> 32);
+    }
+}
+
+static inline void outfilter_scrambleScalar(uint64_t acc[8], const uint8_t* s) {
+    for (size_t i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= outfilter_read64(s + i * 8);
+        acc[i] = a * OUTFILTER_P32_1;
+    }
+}
+
+static void outfilter_loopScalar(uint64_t acc[8], const uint8_t* p, size_t len) {
+    OUTFILTER_LOOP(acc, p, len, outfilter_stripeScalar, outfilter_scrambleScalar);
+}
+
+#if defined(_HF_MEMSWAP_X86)
+HF_ATTR_SSE2 static inline void outfilter_stripeSSE2(
+    __m128i a[4], const uint8_t* p, const uint8_t* s) {
+    for (size_t i = 0; i < 4; i++) {
+        __m128i v   = _mm_loadu_si128((const __m128i*)(p + i * 16));
+        __m128i key = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)(s + i * 16)));
+        __m128i mul = _mm_mul_epu32(key, _mm_srli_epi64(key, 32));
+        a[i]        = _mm_add_epi64(
+            a[i], _mm_add_epi64(mul, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+}
+
+HF_ATTR_SSE2 static inline void outfilter_scrambleSSE2(__m128i a[4], const uint8_t* s) {
+    const __m128i prime = _mm_set1_epi32((int)OUTFILTER_P32_1);
+    for (size_t i = 0; i < 4; i++) {
+        __m128i v  = _mm_xor_si128(a[i], _mm_srli_epi64(a[i], 47));
+        v          = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)(s + i * 16)));
+        __m128i hi = _mm_mul_epu32(_mm_srli_epi64(v, 32), prime);
+        a[i]       = _mm_add_epi64(_mm_mul_epu32(v, prime), _mm_slli_epi64(hi, 32));
+    }
+}
+
+HF_ATTR_SSE2 static void outfilter_loopSSE2(uint64_t acc[8], const uint8_t* p, size_t len) {
+    __m128i a[4];
+    for (size_t i = 0; i < 4; i++) {
+        a[i] = _mm_loadu_si128((const __m128i*)&acc[i * 2]);
+    }
+    OUTFILTER_LOOP(a, p, len, outfilter_stripeSSE2, outfilter_scrambleSSE2);
+    for (size_t i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i*)&acc[i * 2], a[i]);
+    }
+}
+
+HF_ATTR_AVX2 static inline void outfilter_stripeAVX2(
+    __m256i a[2], const uint8_t* p, const uint8_t* s) {
+    for (size_t i = 0; i < 2; i++) {
+        __m256i v   = _mm256_loadu_si256((const __m256i*)(p + i * 32));
+        __m256i key = _mm256_xor_si256(v, _mm256_loadu_si256((const __m256i*)(s + i * 32)));
+        __m256i mul = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+        a[i]        = _mm256_add_epi64(
+            a[i], _mm256_add_epi64(mul, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+}
+
+HF_ATTR_AVX2 static inline void outfilter_scrambleAVX2(__m256i a[2], const uint8_t* s) {
+    const __m256i prime = _mm256_set1_epi32((int)OUTFILTER_P32_1);
+    for (size_t i = 0; i < 2; i++) {
+        __m256i v  = _mm256_xor_si256(a[i], _mm256_srli_epi64(a[i], 47));
+        v          = _mm256_xor_si256(v, _mm256_loadu_si256((const __m256i*)(s + i * 32)));
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(v, 32), prime);
+        a[i]       = _mm256_add_epi64(_mm256_mul_epu32(v, prime), _mm256_slli_epi64(hi, 32));
+    }
+}
+
+HF_ATTR_AVX2 static void outfilter_loopAVX2(uint64_t acc[8], const uint8_t* p, size_t len) {
+    __m256i a[2];
+    for (size_t i = 0; i < 2; i++) {
+        a[i] = _mm256_loadu_si256((const __m256i*)&acc[i * 4]);
+    }
+    OUTFILTER_LOOP(a, p, len, outfilter_stripeAVX2, outfilter_scrambleAVX2);
+    for (size_t i = 0; i < 2; i++) {
+        _mm256_storeu_si256((__m256i*)&acc[i * 4], a[i]);
+    }
+}
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+static uint64_t outfilter_hashLong(const uint8_t* p, size_t len) {
+    uint64_t acc[8] = {OUTFILTER_P32_3, OUTFILTER_P64_1, OUTFILTER_P64_2, OUTFILTER_P64_3,
+        OUTFILTER_P64_4, OUTFILTER_P32_2, OUTFILTER_P64_5, OUTFILTER_P32_1};
+#if defined(_HF_MEMSWAP_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        outfilter_loopAVX2(acc, p, len);
+    } else if (__builtin_cpu_supports("sse2")) {
+        outfilter_loopSSE2(acc, p, len);
+    } else {
+        outfilter_loopScalar(acc, p, len);
+    }
+#else
+    outfilter_loopScalar(acc, p, len);
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+    const uint8_t* s = outfilter_secret;
+    uint64_t       h = len * OUTFILTER_P64_1;
+    for (size_t i = 0; i < 4; i++) {
+        h += outfilter_mulFold(acc[i * 2] ^ outfilter_read64(s + 11 + i * 16),
+            acc[i * 2 + 1] ^ outfilter_read64(s + 11 + i * 16 + 8));
+    }
+    return outfilter_avalanche(h);
+}
+
+/* XXH3-64 of p[0, len) */
+static inline uint64_t outfilter_hash(const uint8_t* p, size_t len) {
+    if (len <= 16) {
+        return outfilter_hash16(p, len);
+    }
+    if (len <= 240) {
+        return outfilter_hash240(p, len);
+    }
+    return outfilter_hashLong(p, len);
+}
+
+/* Mixes 'v' into the hash 'h', for hashes made of parts */
+static inline uint64_t outfilter_combine(uint64_t h, uint64_t v) {
+    return outfilter_avalanche64((outfilter_rotl(h, 27) ^ v) * OUTFILTER_P64_1 + OUTFILTER_P64_4);
+}
+
+/* Remembers 'h', returns true if it was remembered already */
+static inline bool outfilter_seen(outfilter_t* f, uint64_t h) {
+    h |= 1;
+    uint64_t* slot = &f->hashes[(h * OUTFILTER_P64_1) >> (64 - OUTFILTER_BITS)];
+    if (*slot == h) {
+        return true;
+    }
+    *slot = h;
+    return false;
+}
+
+#endif /* _HF_OUTFILTER_H_ */
@@ -0,0 +1,416 @@
+/*
+ * Honggfuzz+ - log of the edits made to the input during a mutation round
+ * -----------------------------------------
+ *
+ * Every edit made through the piece table (piecetab.h) appends a compact record: an overwrite or
+ * an insertion (with the bytes they leave in the input, copied to a payload buffer), a deletion, a
+ * single-byte xor, or a mangle_MemSwap swap (with its variant, the bytes are recomputed). The
+ * payload of a record is copied when the next edit is made, or when the round ends, so that it
+ * holds what the operator wrote after opening the range.
+ *
+ * Overwrites are merged as they are settled: an overwrite which is contained in the previous
+ * overwrite or insertion made by the same operator is folded into its payload, and earlier
+ * overwrites and xors (back to the last insertion, deletion or swap) which it covers are dropped,
+ * as they have no effect on the output. The payloads of dropped records are reclaimed when the
+ * payload buffer fills up. What is left replays the round from the original input, and names the
+ * operators which produced the output.
+ *
+ * Logs are written and read as text, one record per line, with the operator names:
+ *
+ *   size <size before> <size after>
+ *   <operator> overwrite <off> <hex bytes>
+ *   <operator> insert <off> <hex bytes>
+ *   <operator> delete <off> <len>
+ *   <operator> xor <off> <mask>
+ *   <operator> swap <off1> <off2> <len> <variant>
+ */
+
+#ifndef _HF_PATCHLOG_H_
+#define _HF_PATCHLOG_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+#include "memswap.h"
+#include "piecetab.h"
+
+#define PATCHLOG_MAX_RECS 1024U
+/* Payload buffer, in inputs; a round which writes more than that isn't logged completely */
+#define PATCHLOG_PAYLOAD_INPUTS 4U
+
+typedef enum {
+    PATCHLOG_NONE = 0,
+    PATCHLOG_OVERWRITE,
+    PATCHLOG_INSERT,
+    PATCHLOG_DELETE,
+    PATCHLOG_XOR,
+    PATCHLOG_SWAP,
+    PATCHLOG_KINDS_CNT,
+} patchlog_kind_t;
+
+static const char* const patchlog_kindNames[PATCHLOG_KINDS_CNT] = {
+    [PATCHLOG_NONE]      = "none",
+    [PATCHLOG_OVERWRITE] = "overwrite",
+    [PATCHLOG_INSERT]    = "insert",
+    [PATCHLOG_DELETE]    = "delete",
+    [PATCHLOG_XOR]       = "xor",
+    [PATCHLOG_SWAP]      = "swap",
+};
+
+/* Kernels of the mangle_MemSwap variants, indexed by HF_MEMSWAP_* */
+static void (*const patchlog_swaps[])(uint8_t* data, size_t off1, size_t off2, size_t len) = {
+    memswap_Baseline,
+    memswap_SP,
+    memswap_FL,
+};
+
+typedef struct {
+    uint8_t  kind;
+    uint8_t  op;
+    uint8_t  aux; /* xor: mask, swap: variant */
+    uint32_t off;
+    uint32_t len;
+    uint32_t arg; /* overwrite, insert: payload offset, swap: second offset */
+} patchlog_rec_t;
+
+typedef struct {
+    patchlog_rec_t recs[PATCHLOG_MAX_RECS];
+    size_t         cnt;
+    bool           pending; /* the payload of the last record isn't copied yet */
+    bool           complete;
+    uint8_t        op;
+    uint8_t*       payload;
+    size_t         payloadCap;
+    size_t         payloadUsed;
+    size_t         sizeBefore;
+    size_t         sizeAfter;
+} patchlog_t;
+
+__attribute__((noinline, cold)) static void patchlog_grow(patchlog_t* l, size_t payloadCap) {
+    uint8_t* payload = realloc(l->payload, payloadCap);
+    if (payload == NULL) {
+        LOG_F("realloc(size='%zu') failed", payloadCap);
+    }
+    l->payload    = payload;
+    l->payloadCap = payloadCap;
+}
+
+/* Starts a round over 'size' bytes, which can grow to 'cap' */
+static inline void patchlog_begin(patchlog_t* l, size_t size, size_t cap) {
+    if (__builtin_expect(l->payloadCap < PATCHLOG_PAYLOAD_INPUTS * cap, 0)) {
+        patchlog_grow(l, PATCHLOG_PAYLOAD_INPUTS * cap);
+    }
+    l->cnt         = 0;
+    l->pending     = false;
+    l->complete    = (cap <= UINT32_MAX);
+    l->op          = 0;
+    l->payloadUsed = 0;
+    l->sizeBefore  = size;
+    l->sizeAfter   = size;
+}
+
+/* Operator to which the next records are attributed */
+static inline void patchlog_setOp(patchlog_t* l, uint8_t op) {
+    l->op = op;
+}
+
+static inline bool patchlog_covers(const patchlog_rec_t* outer, const patchlog_rec_t* inner) {
+    return inner->off >= outer->off && (inner->off + inner->len) <= (outer->off + outer->len);
+}
+
+/* Merges the last record, an overwrite with its payload, with the earlier ones */
+static inline void patchlog_merge(patchlog_t* l) {
+    patchlog_rec_t* n = &l->recs[l->cnt - 1];
+    if (l->cnt > 1) {
+        patchlog_rec_t* prev = n - 1;
+        if (prev->op == n->op &&
+            (prev->kind == PATCHLOG_OVERWRITE || prev->kind == PATCHLOG_INSERT) &&
+            patchlog_covers(prev, n)) {
+            /* Its payload was the last one copied */
+            memcpy(&l->payload[prev->arg + (n->off - prev->off)], &l->payload[n->arg], n->len);
+            l->payloadUsed -= n->len;
+            l->cnt--;
+            return;
+        }
+    }
+
+    size_t first = l->cnt - 1;
+    while (first > 0 && (l->recs[first - 1].kind == PATCHLOG_OVERWRITE ||
+                            l->recs[first - 1].kind == PATCHLOG_XOR)) {
+        first--;
+    }
+    size_t kept = first;
+    for (size_t i = first; i < l->cnt - 1; i++) {
+        if (!patchlog_covers(n, &l->recs[i])) {
+            l->recs[kept++] = l->recs[i];
+        }
+    }
+    l->recs[kept++] = *n;
+    l->cnt          = kept;
+}
+
+/*
+ * Moves the payloads of the records before the last one down over those of dropped records. They
+ * are in the order of the records
+ */
+__attribute__((noinline, cold)) static void patchlog_compact(patchlog_t* l) {
+    size_t used = 0;
+    for (size_t i = 0; i + 1 < l->cnt; i++) {
+        patchlog_rec_t* r = &l->recs[i];
+        if (r->kind == PATCHLOG_OVERWRITE || r->kind == PATCHLOG_INSERT) {
+            memmove(&l->payload[used], &l->payload[r->arg], r->len);
+            r->arg = (uint32_t)used;
+            used += r->len;
+        }
+    }
+    l->payloadUsed = used;
+}
+
+/* Copies the payload of the last record from the input, once the operator has written it */
+static inline void patchlog_settle(patchlog_t* l, const piecetab_t* t) {
+    if (!l->pending) {
+        return;
+    }
+    l->pending        = false;
+    patchlog_rec_t* r = &l->recs[l->cnt - 1];
+    if (__builtin_expect(r->len > (l->payloadCap - l->payloadUsed), 0)) {
+        patchlog_compact(l);
+    }
+    if (r->len > (l->payloadCap - l->payloadUsed)) {
+        l->complete = false;
+        l->cnt--;
+        return;
+    }
+    piecetab_read(t, r->off, &l->payload[l->payloadUsed], r->len);
+    r->arg = (uint32_t)l->payloadUsed;
+    l->payloadUsed += r->len;
+    if (r->kind == PATCHLOG_OVERWRITE) {
+        patchlog_merge(l);
+    }
+}
+
+/* Records an edit of the input in 't', made right after this call */
+static inline void patchlog_add(patchlog_t* l, const piecetab_t* t, patchlog_kind_t kind,
+    size_t off, size_t len, uint8_t aux, size_t arg) {
+    patchlog_settle(l, t);
+    if (len == 0 || !l->complete) {
+        return;
+    }
+    if (l->cnt == PATCHLOG_MAX_RECS) {
+        l->complete = false;
+        return;
+    }
+    l->recs[l->cnt++] = (patchlog_rec_t){
+        .kind = kind,
+        .op   = l->op,
+        .aux  = aux,
+        .off  = (uint32_t)off,
+        .len  = (uint32_t)len,
+        .arg  = (uint32_t)arg,
+    };
+    l->pending = (kind == PATCHLOG_OVERWRITE || kind == PATCHLOG_INSERT);
+}
+
+static inline void patchlog_end(patchlog_t* l, const piecetab_t* t) {
+    patchlog_settle(l, t);
+    l->sizeAfter = t->size;
+}
+
+/*
+ * Applies a record to 'size' bytes of 'data', which can hold 'cap' bytes. Returns the new size,
+ * or SIZE_MAX if the record doesn't fit
+ */
+static inline size_t patchlog_apply(
+    const patchlog_t* l, const patchlog_rec_t* r, uint8_t* data, size_t size, size_t cap) {
+    size_t off = r->off, len = r->len;
+    switch (r->kind) {
+        case PATCHLOG_OVERWRITE:
+            if (off > size || len > (size - off)) {
+                return SIZE_MAX;
+            }
+            memcpy(&data[off], &l->payload[r->arg], len);
+            return size;
+        case PATCHLOG_INSERT:
+            if (off > size || len > (cap - size)) {
+                return SIZE_MAX;
+            }
+            memmove(&data[off + len], &data[off], size - off);
+            memcpy(&data[off], &l->payload[r->arg], len);
+            return size + len;
+        case PATCHLOG_DELETE:
+            if (off > size || len > (size - off)) {
+                return SIZE_MAX;
+            }
+            memmove(&data[off], &data[off + len], size - off - len);
+            return size - len;
+        case PATCHLOG_XOR:
+            if (off >= size) {
+                return SIZE_MAX;
+            }
+            data[off] ^= r->aux;
+            return size;
+        case PATCHLOG_SWAP:
+            if (HF_MAX(off, (size_t)r->arg) > size || len > (size - HF_MAX(off, (size_t)r->arg)) ||
+                r->aux >= ARRAYSIZE(patchlog_swaps)) {
+                return SIZE_MAX;
+            }
+            patchlog_swaps[r->aux](data, off, r->arg, len);
+            return size;
+        default:
+            return SIZE_MAX;
+    }
+}
+
+/* Writes the log as text, with the names of the operators and of the mangle_MemSwap variants */
+static inline bool patchlog_write(
+    const patchlog_t* l, FILE* f, const char* const* opNames, const char* const* swapNames) {
+    fprintf(f, "size %zu %zu\n", l->sizeBefore, l->sizeAfter);
+    for (size_t i = 0; i < l->cnt; i++) {
+        const patchlog_rec_t* r = &l->recs[i];
+        fprintf(f, "%s %s %" PRIu32, opNames[r->op], patchlog_kindNames[r->kind], r->off);
+        switch (r->kind) {
+            case PATCHLOG_OVERWRITE:
+            case PATCHLOG_INSERT:
+                fputc(' ', f);
+                for (uint32_t j = 0; j < r->len; j++) {
+                    fprintf(f, "%02x", l->payload[r->arg + j]);
+                }
+                break;
+            case PATCHLOG_DELETE:
+                fprintf(f, " %" PRIu32, r->len);
+                break;
+            case PATCHLOG_XOR:
+                fprintf(f, " %02x", r->aux);
+                break;
+            case PATCHLOG_SWAP:
+                fprintf(f, " %" PRIu32 " %" PRIu32 " %s", r->arg, r->len, swapNames[r->aux]);
+                break;
+            default:
+                break;
+        }
+        fputc('\n', f);
+    }
+    return !ferror(f);
+}
+
+static inline int patchlog_lookup(const char* name, const char* const* names, size_t cnt) {
+    for (size_t i = 0; i < cnt; i++) {
+        if (strcasecmp(name, names[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static inline int patchlog_hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/* Parses one record line into the log, the payload buffer grows as needed */
+static inline bool patchlog_parseRec(patchlog_t* l, char* line, const char* const* opNames,
+    size_t opsCnt, const char* const* swapNames, size_t swapsCnt) {
+    char* save   = NULL;
+    char* opName = strtok_r(line, " \t\n", &save);
+    char* kind   = strtok_r(NULL, " \t\n", &save);
+    char* off    = strtok_r(NULL, " \t\n", &save);
+    char* a1     = strtok_r(NULL, " \t\n", &save);
+    char* a2     = strtok_r(NULL, " \t\n", &save);
+    char* a3     = strtok_r(NULL, " \t\n", &save);
+    int   op     = opName ? patchlog_lookup(opName, opNames, opsCnt) : -1;
+    int   k      = kind ? patchlog_lookup(kind, patchlog_kindNames, PATCHLOG_KINDS_CNT) : -1;
+    if (op < 0 || k <= PATCHLOG_NONE || off == NULL || a1 == NULL ||
+        l->cnt == PATCHLOG_MAX_RECS) {
+        return false;
+    }
+
+    patchlog_rec_t r = {.kind = (uint8_t)k, .op = (uint8_t)op, .off = strtoul(off, NULL, 10)};
+    switch (k) {
+        case PATCHLOG_OVERWRITE:
+        case PATCHLOG_INSERT: {
+            size_t hexLen = strlen(a1);
+            if (hexLen == 0 || (hexLen % 2) != 0) {
+                return false;
+            }
+            r.len = (uint32_t)(hexLen / 2);
+            if (r.len > (l->payloadCap - l->payloadUsed)) {
+                patchlog_grow(l, HF_MAX(l->payloadCap * 2, l->payloadUsed + r.len));
+            }
+            r.arg = (uint32_t)l->payloadUsed;
+            for (size_t j = 0; j < r.len; j++) {
+                int hi = patchlog_hexDigit(a1[j * 2]), lo = patchlog_hexDigit(a1[j * 2 + 1]);
+                if (hi < 0 || lo < 0) {
+                    return false;
+                }
+                l->payload[l->payloadUsed++] = (uint8_t)((hi << 4) | lo);
+            }
+            break;
+        }
+        case PATCHLOG_DELETE:
+            r.len = strtoul(a1, NULL, 10);
+            break;
+        case PATCHLOG_XOR:
+            r.len = 1;
+            r.aux = (uint8_t)strtoul(a1, NULL, 16);
+            break;
+        case PATCHLOG_SWAP: {
+            int variant = a3 ? patchlog_lookup(a3, swapNames, swapsCnt) : -1;
+            if (a2 == NULL || variant < 0) {
+                return false;
+            }
+            r.arg = strtoul(a1, NULL, 10);
+            r.len = strtoul(a2, NULL, 10);
+            r.aux = (uint8_t)variant;
+            break;
+        }
+        default:
+            return false;
+    }
+    l->recs[l->cnt++] = r;
+    return true;
+}
+
+/* Reads a log written by patchlog_write() */
+static inline bool patchlog_read(patchlog_t* l, FILE* f, const char* const* opNames,
+    size_t opsCnt, const char* const* swapNames, size_t swapsCnt) {
+    l->cnt         = 0;
+    l->payloadUsed = 0;
+    l->complete    = false;
+
+    char*  line    = NULL;
+    size_t lineCap = 0;
+    bool   sized   = false;
+    bool   ok      = true;
+    while (ok && getline(&line, &lineCap, f) != -1) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (strncmp(line, "size ", 5) == 0) {
+            sized = (sscanf(line, "size %zu %zu", &l->sizeBefore, &l->sizeAfter) == 2);
+            ok    = sized;
+            continue;
+        }
+        ok = patchlog_parseRec(l, line, opNames, opsCnt, swapNames, swapsCnt);
+    }
+    free(line);
+    l->complete = ok && sized;
+    return l->complete;
+}
+
+#endif /* _HF_PATCHLOG_H_ */
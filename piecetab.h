@@ -0,0 +1,263 @@
+/*
+ * Honggfuzz+ - piece table over the input, for the length of a mutation round
+ * -----------------------------------------
+ *
+ * The input is kept as a list of pieces, each a run of bytes either in the input buffer (at
+ * whatever offset they were when the round started) or in a per-thread add buffer, which receives
+ * the inserted bytes. Insertions and deletions split at most two pieces, and cost O(len + pieces)
+ * wherever they happen. Bytes are modified in place through spans: a span inside one piece points
+ * at its bytes, a span across pieces is copied to the add buffer first, and replaces them.
+ *
+ * piecetab_flatten() writes the pieces back to the input buffer, once per round. The pieces of the
+ * input buffer are never reordered, so those moving down are moved in ascending order and those
+ * moving up in descending order without overwriting each other, and the added ones are copied last.
+ * A round with a single insertion or deletion would move the tail twice that way, so the first
+ * one is made in place, by moving the tail, as are those which move no more bytes than they insert
+ * or delete, and all of them in inputs below PIECETAB_MIN_SIZE. Until pieces are needed the table
+ * stays flat, with spans pointing into the input buffer.
+ *
+ * If the add buffer or the list of pieces fills up, the table is flattened and the round goes on.
+ */
+
+#ifndef _HF_PIECETAB_H_
+#define _HF_PIECETAB_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+
+#define PIECETAB_MAX_PIECES 128U
+/* Below this, moving the tail is cheaper than keeping track of pieces */
+#define PIECETAB_MIN_SIZE (32U * 1024U)
+#define PIECETAB_ALIGN      64U
+
+typedef struct {
+    uint8_t* src;
+    size_t   len;
+    bool     added;
+} piecetab_piece_t;
+
+typedef struct {
+    uint8_t*         data;
+    size_t           cap;
+    size_t           size;
+    bool             flat;
+    bool             moved;
+    size_t           cnt;
+    piecetab_piece_t pieces[PIECETAB_MAX_PIECES];
+    uint8_t*         add;
+    size_t           addCap;
+    size_t           addUsed;
+} piecetab_t;
+
+/* Only called between rounds, so the old add buffer can go */
+__attribute__((noinline, cold)) static void piecetab_grow(piecetab_t* t, size_t addCap) {
+    free(t->add);
+    t->add    = NULL;
+    t->addCap = 0;
+    addCap    = HF_MAX(addCap, PIECETAB_ALIGN);
+    if (posix_memalign((void**)&t->add, PIECETAB_ALIGN, addCap) != 0) {
+        LOG_F("posix_memalign(size='%zu') failed", addCap);
+    }
+    t->addCap = addCap;
+}
+
+/* Starts a round over 'size' bytes of 'data', which can hold 'cap' bytes */
+static inline void piecetab_begin(piecetab_t* t, uint8_t* data, size_t size, size_t cap) {
+    if (__builtin_expect(t->addCap < cap, 0)) {
+        piecetab_grow(t, cap);
+    }
+    t->data    = data;
+    t->cap     = cap;
+    t->size    = size;
+    t->flat    = true;
+    t->moved   = false;
+    t->cnt     = 0;
+    t->addUsed = 0;
+}
+
+static inline void piecetab_flatten(piecetab_t* t) {
+    if (t->flat) {
+        return;
+    }
+    size_t pos = 0;
+    for (size_t i = 0; i < t->cnt; i++) {
+        const piecetab_piece_t* p = &t->pieces[i];
+        if (!p->added && p->src > &t->data[pos]) {
+            memmove(&t->data[pos], p->src, p->len);
+        }
+        pos += p->len;
+    }
+    for (size_t i = t->cnt; i-- > 0;) {
+        const piecetab_piece_t* p = &t->pieces[i];
+        pos -= p->len;
+        if (!p->added && p->src < &t->data[pos]) {
+            memmove(&t->data[pos], p->src, p->len);
+        }
+    }
+    for (size_t i = 0; i < t->cnt; i++) {
+        const piecetab_piece_t* p = &t->pieces[i];
+        if (p->added) {
+            memcpy(&t->data[pos], p->src, p->len);
+        }
+        pos += p->len;
+    }
+    t->flat    = true;
+    t->cnt     = 0;
+    t->addUsed = 0;
+}
+
+/* Makes room for 'pieces' more pieces and 'addLen' added bytes, leaving the flat state */
+static inline void piecetab_prepare(piecetab_t* t, size_t pieces, size_t addLen) {
+    if (!t->flat && (t->cnt + pieces) <= PIECETAB_MAX_PIECES &&
+        (t->addUsed + addLen) <= t->addCap) {
+        return;
+    }
+    piecetab_flatten(t);
+    t->flat      = false;
+    t->cnt       = (t->size > 0) ? 1 : 0;
+    t->pieces[0] = (piecetab_piece_t){.src = t->data, .len = t->size, .added = false};
+}
+
+/* Index of the piece holding 'off' (< size), and the offset within it */
+static inline size_t piecetab_find(const piecetab_t* t, size_t off, size_t* within) {
+    size_t i = 0;
+    for (; off >= t->pieces[i].len; i++) {
+        off -= t->pieces[i].len;
+    }
+    *within = off;
+    return i;
+}
+
+/* Makes a piece start at 'off' (<= size), and returns its index; needs room for one piece */
+static inline size_t piecetab_split(piecetab_t* t, size_t off) {
+    if (off == t->size) {
+        return t->cnt;
+    }
+    size_t within;
+    size_t i = piecetab_find(t, off, &within);
+    if (within == 0) {
+        return i;
+    }
+    memmove(&t->pieces[i + 2], &t->pieces[i + 1], (t->cnt - i - 1) * sizeof(t->pieces[0]));
+    t->pieces[i + 1] = (piecetab_piece_t){
+        .src   = &t->pieces[i].src[within],
+        .len   = t->pieces[i].len - within,
+        .added = t->pieces[i].added,
+    };
+    t->pieces[i].len = within;
+    t->cnt++;
+    return i + 1;
+}
+
+/* Contiguous bytes from 'off' (< size) to the end of its piece, their number in 'len' */
+static inline uint8_t* piecetab_segment(const piecetab_t* t, size_t off, size_t* len) {
+    if (t->flat) {
+        *len = t->size - off;
+        return &t->data[off];
+    }
+    size_t within;
+    size_t i = piecetab_find(t, off, &within);
+    *len     = t->pieces[i].len - within;
+    return &t->pieces[i].src[within];
+}
+
+/* Copies bytes [off, off + len) to 'dst', without changing the pieces */
+static inline void piecetab_read(const piecetab_t* t, size_t off, uint8_t* dst, size_t len) {
+    while (len > 0) {
+        size_t         segLen;
+        const uint8_t* seg = piecetab_segment(t, off, &segLen);
+        segLen             = HF_MIN(segLen, len);
+        memcpy(dst, seg, segLen);
+        dst += segLen;
+        off += segLen;
+        len -= segLen;
+    }
+}
+
+/* Contiguous bytes [off, off + len), valid until the next piecetab_* call which changes the table */
+static inline uint8_t* piecetab_span(piecetab_t* t, size_t off, size_t len) {
+    if (t->flat || len == 0) {
+        return &t->data[off];
+    }
+    size_t within;
+    size_t i = piecetab_find(t, off, &within);
+    if ((within + len) <= t->pieces[i].len) {
+        return &t->pieces[i].src[within];
+    }
+
+    /* Across pieces, which are replaced with a copy of their bytes */
+    piecetab_prepare(t, 2, len);
+    if (t->cnt == 1) {
+        /* Flattened to make room */
+        return &t->data[off];
+    }
+    size_t   first = piecetab_split(t, off);
+    size_t   last  = piecetab_split(t, off + len);
+    uint8_t* p     = &t->add[t->addUsed];
+    for (size_t j = first, n = 0; j < last; j++) {
+        memcpy(&p[n], t->pieces[j].src, t->pieces[j].len);
+        n += t->pieces[j].len;
+    }
+    t->addUsed += len;
+    t->pieces[first] = (piecetab_piece_t){.src = p, .len = len, .added = true};
+    memmove(&t->pieces[first + 1], &t->pieces[last], (t->cnt - last) * sizeof(t->pieces[0]));
+    t->cnt -= last - first - 1;
+    return p;
+}
+
+/* Whether an insertion or deletion in a flat table should move the tail instead of splitting it */
+static inline bool piecetab_inPlace(const piecetab_t* t) {
+    return !t->moved || t->size < PIECETAB_MIN_SIZE;
+}
+
+/*
+ * Opens 'len' bytes of unspecified content at 'off' (<= size), with size + len <= cap, and returns
+ * them. Valid until the next piecetab_* call which changes the table.
+ */
+static inline uint8_t* piecetab_insert(piecetab_t* t, size_t off, size_t len) {
+    if ((t->flat && piecetab_inPlace(t)) || (t->size - off) <= len) {
+        piecetab_flatten(t);
+        memmove(&t->data[off + len], &t->data[off], t->size - off);
+        t->size += len;
+        t->moved = true;
+        return &t->data[off];
+    }
+    piecetab_prepare(t, 2, len);
+    size_t   i = piecetab_split(t, off);
+    uint8_t* p = &t->add[t->addUsed];
+    t->addUsed += len;
+    if (i > 0 && t->pieces[i - 1].added && &t->pieces[i - 1].src[t->pieces[i - 1].len] == p) {
+        /* Right after the previous insertion */
+        t->pieces[i - 1].len += len;
+    } else {
+        memmove(&t->pieces[i + 1], &t->pieces[i], (t->cnt - i) * sizeof(t->pieces[0]));
+        t->pieces[i] = (piecetab_piece_t){.src = p, .len = len, .added = true};
+        t->cnt++;
+    }
+    t->size += len;
+    return p;
+}
+
+/* Removes bytes [off, off + len) */
+static inline void piecetab_delete(piecetab_t* t, size_t off, size_t len) {
+    if (t->flat && (piecetab_inPlace(t) || (t->size - off - len) <= len)) {
+        memmove(&t->data[off], &t->data[off + len], t->size - off - len);
+        t->size -= len;
+        t->moved = true;
+        return;
+    }
+    piecetab_prepare(t, 2, 0);
+    size_t first = piecetab_split(t, off);
+    size_t last  = piecetab_split(t, off + len);
+    memmove(&t->pieces[first], &t->pieces[last], (t->cnt - last) * sizeof(t->pieces[0]));
+    t->cnt -= last - first;
+    t->size -= len;
+}
+
+#endif /* _HF_PIECETAB_H_ */
@@ -0,0 +1,100 @@
+/*
+ * Honggfuzz+ - folding of bytes into the printable range, for inputs mutated in printable mode
+ * -----------------------------------------
+ *
+ * With cfg.only_printable the operators write bytes as they would in binary mode, and the ranges
+ * which a round wrote are folded into [32, 126] once, when it ends. Printable bytes are kept, so
+ * folding a range twice, or one which only partly changed, is harmless, and the others become
+ * c % 95 + 32, as with util_turnToPrintable(). The scalar path looks bytes up in a table, the
+ * vector ones compute the same with compares: c % 95 is c minus 95 for each of 95 and 190 which
+ * it reaches.
+ */
+
+#ifndef _HF_PRINTABLE_H_
+#define _HF_PRINTABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memswap.h"
+
+#define PRINTABLE_BYTE(c) ((uint8_t)(((c) - 32U < 95U) ? (c) : ((c) % 95U + 32U)))
+#define PRINTABLE_R4(c)                                                                            \
+    PRINTABLE_BYTE(c), PRINTABLE_BYTE(c + 1), PRINTABLE_BYTE(c + 2), PRINTABLE_BYTE(c + 3)
+#define PRINTABLE_R16(c)                                                                           \
+    PRINTABLE_R4(c), PRINTABLE_R4(c + 4), PRINTABLE_R4(c + 8), PRINTABLE_R4(c + 12)
+#define PRINTABLE_R64(c)                                                                           \
+    PRINTABLE_R16(c), PRINTABLE_R16(c + 16), PRINTABLE_R16(c + 32), PRINTABLE_R16(c + 48)
+
+static const uint8_t printable_lut[256] __attribute__((aligned(64))) = {
+    PRINTABLE_R64(0U),
+    PRINTABLE_R64(64U),
+    PRINTABLE_R64(128U),
+    PRINTABLE_R64(192U),
+};
+
+static inline void printable_foldScalar(uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        p[i] = printable_lut[p[i]];
+    }
+}
+
+#if defined(_HF_MEMSWAP_X86)
+HF_ATTR_SSE2 static void printable_foldSSE2(uint8_t* p, size_t len) {
+    const __m128i lo   = _mm_set1_epi8(32);
+    const __m128i span = _mm_set1_epi8(94);
+    const __m128i k95  = _mm_set1_epi8(95);
+    const __m128i k190 = _mm_set1_epi8((char)190);
+    size_t        i    = 0;
+    for (; (i + 16) <= len; i += 16) {
+        __m128i c     = _mm_loadu_si128((const __m128i*)&p[i]);
+        __m128i off   = _mm_sub_epi8(c, lo);
+        __m128i keep  = _mm_cmpeq_epi8(_mm_min_epu8(off, span), off);
+        __m128i ge95  = _mm_cmpeq_epi8(_mm_max_epu8(c, k95), c);
+        __m128i ge190 = _mm_cmpeq_epi8(_mm_max_epu8(c, k190), c);
+        __m128i r     = _mm_sub_epi8(c, _mm_and_si128(ge95, k95));
+        r             = _mm_add_epi8(_mm_sub_epi8(r, _mm_and_si128(ge190, k95)), lo);
+        r             = _mm_or_si128(_mm_and_si128(keep, c), _mm_andnot_si128(keep, r));
+        _mm_storeu_si128((__m128i*)&p[i], r);
+    }
+    printable_foldScalar(&p[i], len - i);
+}
+
+HF_ATTR_AVX2 static void printable_foldAVX2(uint8_t* p, size_t len) {
+    const __m256i lo   = _mm256_set1_epi8(32);
+    const __m256i span = _mm256_set1_epi8(94);
+    const __m256i k95  = _mm256_set1_epi8(95);
+    const __m256i k190 = _mm256_set1_epi8((char)190);
+    size_t        i    = 0;
+    for (; (i + 32) <= len; i += 32) {
+        __m256i c     = _mm256_loadu_si256((const __m256i*)&p[i]);
+        __m256i off   = _mm256_sub_epi8(c, lo);
+        __m256i keep  = _mm256_cmpeq_epi8(_mm256_min_epu8(off, span), off);
+        __m256i ge95  = _mm256_cmpeq_epi8(_mm256_max_epu8(c, k95), c);
+        __m256i ge190 = _mm256_cmpeq_epi8(_mm256_max_epu8(c, k190), c);
+        __m256i r     = _mm256_sub_epi8(c, _mm256_and_si256(ge95, k95));
+        r             = _mm256_add_epi8(_mm256_sub_epi8(r, _mm256_and_si256(ge190, k95)), lo);
+        _mm256_storeu_si256((__m256i*)&p[i], _mm256_blendv_epi8(r, c, keep));
+    }
+    printable_foldSSE2(&p[i], len - i);
+}
+#endif /* defined(_HF_MEMSWAP_X86) */
+
+/* Folds p[0, len) into the printable range, keeping the bytes which are printable already */
+static inline void printable_fold(uint8_t* p, size_t len) {
+#if defined(_HF_MEMSWAP_X86)
+    if (len >= 16) {
+        if (__builtin_cpu_supports("avx2") && len >= 32) {
+            printable_foldAVX2(p, len);
+            return;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            printable_foldSSE2(p, len);
+            return;
+        }
+    }
+#endif /* defined(_HF_MEMSWAP_X86) */
+    printable_foldScalar(p, len);
+}
+
+#endif /* _HF_PRINTABLE_H_ */
@@ -0,0 +1,88 @@
+/*
+ * Honggfuzz+ - per-thread scratch arena for the mangle operators
+ * -----------------------------------------
+ *
+ * A single 64-byte-aligned block, sized at the start of each mangle_mangleContent() round from
+ * mutate.maxInputSz, from which operators borrow temporary buffers with a bump pointer. Borrowing
+ * is stack-like: an operator takes a mark, allocates, and releases back to the mark when it's
+ * done; the whole arena is reset at the end of the round. The block is only reallocated when the
+ * maximum input size grows, so mutation itself doesn't call malloc() or free().
+ */
+
+#ifndef _HF_SCRATCH_H_
+#define _HF_SCRATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "libhfcommon/common.h"
+#include "libhfcommon/log.h"
+
+#define SCRATCH_ALIGN 64U
+/* Temporary buffers are at most one input in size, leave room for one nested borrow */
+#define SCRATCH_INPUTS 2U
+
+typedef struct {
+    uint8_t* base;
+    size_t   cap;
+    size_t   used;
+} scratch_t;
+
+static __thread scratch_t scratch_arena;
+
+static inline size_t scratch_roundUp(size_t sz) {
+    return (sz + (SCRATCH_ALIGN - 1)) & ~(size_t)(SCRATCH_ALIGN - 1);
+}
+
+/* Only called with nothing borrowed, so the old block can go */
+__attribute__((noinline, cold)) static void scratch_grow(size_t cap) {
+    scratch_t* a = &scratch_arena;
+    if (a->used != 0) {
+        LOG_F("Scratch arena overflow: %zu bytes in use, %zu needed, capacity: %zu", a->used, cap,
+            a->cap);
+    }
+    free(a->base);
+    a->base = NULL;
+    a->cap  = 0;
+    cap     = scratch_roundUp(cap);
+    if (posix_memalign((void**)&a->base, SCRATCH_ALIGN, cap) != 0) {
+        LOG_F("posix_memalign(size='%zu') failed", cap);
+    }
+    a->cap = cap;
+}
+
+/* Makes sure that the arena can hold 'cap' bytes, done at the start of a round */
+static inline void scratch_reserve(size_t cap) {
+    if (__builtin_expect(scratch_arena.cap < cap, 0)) {
+        scratch_grow(cap);
+    }
+}
+
+static inline size_t scratch_mark(void) {
+    return scratch_arena.used;
+}
+
+static inline void scratch_release(size_t mark) {
+    scratch_arena.used = mark;
+}
+
+static inline void scratch_reset(void) {
+    scratch_arena.used = 0;
+}
+
+/* A SCRATCH_ALIGN-aligned buffer of 'len' bytes, valid until released */
+static inline uint8_t* scratch_alloc(size_t len) {
+    scratch_t* a   = &scratch_arena;
+    size_t     off = a->used;
+    size_t     end = off + scratch_roundUp(len);
+    if (__builtin_expect(end > a->cap, 0)) {
+        scratch_grow(HF_MAX(end, SCRATCH_ALIGN));
+        off = 0;
+        end = scratch_roundUp(len);
+    }
+    a->used = end;
+    return &a->base[off];
+}
+
+#endif /* _HF_SCRATCH_H_ */
@@ -0,0 +1,441 @@
+/*
+ * Honggfuzz+ - converter of AFL++ dictionaries to the mapped format of dictblob.h
+ * -----------------------------------------
+ *
+ * Reads AFL++ -x dictionaries (text files with one "token" per line, optionally named and with an
+ * @level, or directories with one token per file, like the auto_extras/ which afl-fuzz saves the
+ * LTO autodictionary to) and raw autodictionaries (a length byte followed by the token, as put
+ * in the binary by the LTO pass), drops duplicates and tokens over DICTBLOB_MAX_LEN bytes, and
+ * writes one dictionary file, for HONGGFUZZ_DICT. With -d, prints what a dictionary file holds.
+ *
+ * Usage: hfdict -o output.hfdict [-x dictionary]... [-a autodictionary]...
+ *        hfdict -d input.hfdict
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dictblob.h"
+
+typedef struct {
+    uint64_t off;
+    uint32_t len;
+} hfdict_tok_t;
+
+static struct {
+    uint8_t*      bytes;
+    size_t        bytesUsed;
+    size_t        bytesCap;
+    hfdict_tok_t* toks;
+    uint32_t      cnt;
+    uint32_t      cap;
+    uint32_t*     slots; /* token index + 1, 0 if empty */
+    size_t        slotsCnt;
+    uint32_t      maxLen;
+    size_t        dups;
+    size_t        skipped;
+} hfdict;
+
+static void* hfdict_realloc(void* ptr, size_t sz) {
+    void* p = realloc(ptr, sz);
+    if (p == NULL) {
+        fprintf(stderr, "realloc(size='%zu') failed\n", sz);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* FNV-1a */
+static uint64_t hfdict_hash(const uint8_t* tok, size_t len) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ tok[i]) * 0x100000001B3ULL;
+    }
+    return h ^ len;
+}
+
+static uint32_t* hfdict_slot(const uint8_t* tok, size_t len) {
+    size_t mask = hfdict.slotsCnt - 1;
+    for (size_t i = hfdict_hash(tok, len) & mask;; i = (i + 1) & mask) {
+        uint32_t* slot = &hfdict.slots[i];
+        if (*slot == 0) {
+            return slot;
+        }
+        uint32_t t = *slot - 1;
+        if (hfdict.toks[t].len == len && memcmp(&hfdict.bytes[hfdict.toks[t].off], tok, len) == 0) {
+            return slot;
+        }
+    }
+}
+
+/* Keeps the load factor of the hash table under 1/2 */
+static void hfdict_rehash(void) {
+    free(hfdict.slots);
+    hfdict.slotsCnt = hfdict.slotsCnt ? hfdict.slotsCnt * 2 : 1024;
+    hfdict.slots    = calloc(hfdict.slotsCnt, sizeof(hfdict.slots[0]));
+    if (hfdict.slots == NULL) {
+        fprintf(stderr, "calloc(nmemb='%zu') failed\n", hfdict.slotsCnt);
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t t = 0; t < hfdict.cnt; t++) {
+        *hfdict_slot(&hfdict.bytes[hfdict.toks[t].off], hfdict.toks[t].len) = t + 1;
+    }
+}
+
+static void hfdict_add(const uint8_t* tok, size_t len) {
+    if (len == 0 || len > DICTBLOB_MAX_LEN) {
+        hfdict.skipped++;
+        return;
+    }
+    if ((hfdict.cnt + 1ULL) * 2 > hfdict.slotsCnt) {
+        hfdict_rehash();
+    }
+    uint32_t* slot = hfdict_slot(tok, len);
+    if (*slot != 0) {
+        hfdict.dups++;
+        return;
+    }
+    if (hfdict.bytesUsed + len > UINT32_MAX || hfdict.cnt == UINT32_MAX - 1) {
+        fprintf(stderr, "The dictionary is too large\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hfdict.bytesUsed + len > hfdict.bytesCap) {
+        hfdict.bytesCap = (hfdict.bytesCap + len) * 2;
+        hfdict.bytes    = hfdict_realloc(hfdict.bytes, hfdict.bytesCap);
+    }
+    if (hfdict.cnt == hfdict.cap) {
+        hfdict.cap  = hfdict.cap ? hfdict.cap * 2 : 1024;
+        hfdict.toks = hfdict_realloc(hfdict.toks, hfdict.cap * sizeof(hfdict.toks[0]));
+    }
+    memcpy(&hfdict.bytes[hfdict.bytesUsed], tok, len);
+    hfdict.toks[hfdict.cnt].off = hfdict.bytesUsed;
+    hfdict.toks[hfdict.cnt].len = (uint32_t)len;
+    hfdict.bytesUsed += len;
+    hfdict.cnt++;
+    *slot         = hfdict.cnt;
+    if (len > hfdict.maxLen) {
+        hfdict.maxLen = (uint32_t)len;
+    }
+}
+
+static int hfdict_hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*
+ * One line of an AFL++ dictionary: [name] [@level] [=] "value", with \\, \" and \xNN escapes.
+ * Returns false if it isn't one
+ */
+static bool hfdict_parseLine(char* line) {
+    char* p = line;
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    char* end = p + strlen(p);
+    while (end > p && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+        *--end = '\0';
+    }
+    if (*p == '\0' || *p == '#') {
+        return true;
+    }
+    if (end[-1] != '"') {
+        return false;
+    }
+
+    while (*p == '_' || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+           (*p >= '0' && *p <= '9')) {
+        p++;
+    }
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == '@') {
+        /* Levels aren't used, all tokens are kept */
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+    }
+    if (*p == '=') {
+        p++;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+    }
+    if (*p != '"' || p == end - 1) {
+        return false;
+    }
+
+    uint8_t tok[DICTBLOB_MAX_LEN + 1];
+    size_t  len = 0;
+    for (p++; p < end - 1; p++) {
+        uint8_t c = (uint8_t)*p;
+        if (c == '\\') {
+            p++;
+            if (*p == '\\' || *p == '"') {
+                c = (uint8_t)*p;
+            } else if (*p == 'x' && hfdict_hexDigit(p[1]) >= 0 && hfdict_hexDigit(p[2]) >= 0) {
+                c = (uint8_t)((hfdict_hexDigit(p[1]) << 4) | hfdict_hexDigit(p[2]));
+                p += 2;
+            } else {
+                return false;
+            }
+        }
+        if (len < sizeof(tok)) {
+            tok[len] = c;
+        }
+        len++;
+    }
+    if (p != end - 1) {
+        return false;
+    }
+    if (len > DICTBLOB_MAX_LEN) {
+        hfdict.skipped++;
+        return true;
+    }
+    hfdict_add(tok, len);
+    return true;
+}
+
+/* Reads up to 'max' bytes of 'path', returns the number read, or -1 if it can't be read */
+static ssize_t hfdict_readFile(const char* path, uint8_t* buf, size_t max) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    size_t len = fread(buf, 1, max, f);
+    bool   err = ferror(f);
+    fclose(f);
+    return err ? -1 : (ssize_t)len;
+}
+
+/* A directory of tokens, one per file, as in afl-fuzz -x dir/ */
+static void hfdict_loadDir(const char* path) {
+    DIR* dir = opendir(path);
+    if (dir == NULL) {
+        fprintf(stderr, "Couldn't open directory '%s': %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    uint8_t tok[DICTBLOB_MAX_LEN + 1];
+    for (struct dirent* ent; (ent = readdir(dir)) != NULL;) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        char file[4096];
+        snprintf(file, sizeof(file), "%s/%s", path, ent->d_name);
+        struct stat st;
+        if (stat(file, &st) == -1 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        ssize_t len = hfdict_readFile(file, tok, sizeof(tok));
+        if (len < 0) {
+            fprintf(stderr, "Couldn't read '%s': %s\n", file, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        hfdict_add(tok, (size_t)len);
+    }
+    closedir(dir);
+}
+
+static void hfdict_loadDict(const char* path) {
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        hfdict_loadDir(path);
+        return;
+    }
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open '%s': %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    char*  line    = NULL;
+    size_t lineCap = 0;
+    for (size_t lineNo = 1; getline(&line, &lineCap, f) != -1; lineNo++) {
+        if (!hfdict_parseLine(line)) {
+            fprintf(stderr, "%s:%zu: not a dictionary entry, skipped\n", path, lineNo);
+            hfdict.skipped++;
+        }
+    }
+    free(line);
+    fclose(f);
+}
+
+/* Raw autodictionary: <length byte><token>... */
+static void hfdict_loadAuto(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open '%s': %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    uint8_t tok[UINT8_MAX];
+    for (int len; (len = fgetc(f)) != EOF;) {
+        if (fread(tok, 1, (size_t)len, f) != (size_t)len) {
+            fprintf(stderr, "'%s' is truncated\n", path);
+            exit(EXIT_FAILURE);
+        }
+        hfdict_add(tok, (size_t)len);
+    }
+    fclose(f);
+}
+
+static bool hfdict_fwrite(const void* ptr, size_t sz, FILE* f) {
+    return fwrite(ptr, 1, sz, f) == sz;
+}
+
+/* Tokens by length, into a temporary file which is renamed to 'path' */
+static void hfdict_write(const char* path) {
+    size_t             bucketsCnt = hfdict.maxLen + 1;
+    dictblob_bucket_t* buckets    = calloc(bucketsCnt, sizeof(dictblob_bucket_t));
+    dictblob_tok_t*    index      = calloc(hfdict.cnt + 1U, sizeof(dictblob_tok_t));
+    uint8_t*           blob       = malloc(hfdict.bytesUsed + 1U);
+    if (buckets == NULL || index == NULL || blob == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t t = 0; t < hfdict.cnt; t++) {
+        buckets[hfdict.toks[t].len].cnt++;
+    }
+    for (size_t len = 1; len < bucketsCnt; len++) {
+        buckets[len].first = buckets[len - 1].first + buckets[len - 1].cnt;
+    }
+
+    /* The blob is in the order of the index, so tokens of a length are next to each other */
+    uint32_t* next = calloc(bucketsCnt, sizeof(uint32_t));
+    uint64_t* offs = calloc(bucketsCnt, sizeof(uint64_t));
+    if (next == NULL || offs == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t len = 1; len < bucketsCnt; len++) {
+        offs[len] = offs[len - 1] + (uint64_t)buckets[len - 1].cnt * (len - 1);
+    }
+    for (uint32_t t = 0; t < hfdict.cnt; t++) {
+        uint32_t len = hfdict.toks[t].len;
+        uint32_t i   = buckets[len].first + next[len]++;
+        uint64_t off = offs[len] + (uint64_t)(i - buckets[len].first) * len;
+        index[i]     = (dictblob_tok_t){.off = (uint32_t)off, .len = len};
+        memcpy(&blob[off], &hfdict.bytes[hfdict.toks[t].off], len);
+    }
+
+    dictblob_hdr_t hdr = {
+        .version    = DICTBLOB_VERSION,
+        .maxLen     = hfdict.maxLen,
+        .cnt        = hfdict.cnt,
+        .bucketsOff = sizeof(dictblob_hdr_t),
+    };
+    memcpy(hdr.magic, DICTBLOB_MAGIC, sizeof(hdr.magic));
+    hdr.indexOff = hdr.bucketsOff + bucketsCnt * sizeof(dictblob_bucket_t);
+    hdr.blobOff  = hdr.indexOff + (uint64_t)hfdict.cnt * sizeof(dictblob_tok_t);
+    hdr.blobSize = hfdict.bytesUsed;
+
+    char tmpPath[4096];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* f = fopen(tmpPath, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Couldn't open '%s' for writing: %s\n", tmpPath, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    bool ok = hfdict_fwrite(&hdr, sizeof(hdr), f) &&
+              hfdict_fwrite(buckets, bucketsCnt * sizeof(dictblob_bucket_t), f) &&
+              hfdict_fwrite(index, hfdict.cnt * sizeof(dictblob_tok_t), f) &&
+              hfdict_fwrite(blob, hfdict.bytesUsed, f);
+    if (fclose(f) != 0 || !ok || rename(tmpPath, path) == -1) {
+        fprintf(stderr, "Couldn't write '%s': %s\n", path, strerror(errno));
+        unlink(tmpPath);
+        exit(EXIT_FAILURE);
+    }
+    free(offs);
+    free(next);
+    free(blob);
+    free(index);
+    free(buckets);
+}
+
+static void hfdict_dump(const char* path) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    dictblob_t  d;
+    const char* err;
+    if (!dictblob_open(&d, path, &err)) {
+        fprintf(stderr, "'%s' %s\n", path, err);
+        exit(EXIT_FAILURE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    printf("%s: %" PRIu32 " tokens, longest %" PRIu32 " bytes, %zu bytes, opened in %.3f ms\n",
+        path, d.cnt, d.maxLen, d.mapSz, ms);
+    printf("# %6s %10s\n", "length", "tokens");
+    for (size_t len = 1; len <= d.maxLen; len++) {
+        if (dictblob_cntOfLen(&d, len)) {
+            printf("  %6zu %10zu\n", len, dictblob_cntOfLen(&d, len));
+        }
+    }
+    dictblob_close(&d);
+}
+
+static void hfdict_usage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s -o output.hfdict [-x dictionary]... [-a autodictionary]...\n"
+        "       %s -d input.hfdict\n"
+        "  -o  dictionary file to write, for HONGGFUZZ_DICT\n"
+        "  -x  AFL++ dictionary: a text file, or a directory with one token per file (e.g.\n"
+        "      queue/.state/auto_extras/ with the LTO autodictionary)\n"
+        "  -a  raw autodictionary: a length byte followed by the token, repeated\n"
+        "  -d  print the number of tokens of each length in a dictionary file\n",
+        argv0, argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+    const char* out    = NULL;
+    bool        inputs = false;
+    for (int c; (c = getopt(argc, argv, "o:x:a:d:h")) != -1;) {
+        switch (c) {
+            case 'o':
+                out = optarg;
+                break;
+            case 'x':
+                hfdict_loadDict(optarg);
+                inputs = true;
+                break;
+            case 'a':
+                hfdict_loadAuto(optarg);
+                inputs = true;
+                break;
+            case 'd':
+                hfdict_dump(optarg);
+                return EXIT_SUCCESS;
+            default:
+                hfdict_usage(argv[0]);
+        }
+    }
+    if (out == NULL || !inputs || optind != argc) {
+        hfdict_usage(argv[0]);
+    }
+
+    hfdict_write(out);
+    printf("%s: %" PRIu32 " tokens (%zu bytes), %zu duplicates and %zu invalid or longer than %u "
+           "bytes dropped\n",
+        out, hfdict.cnt, hfdict.bytesUsed, hfdict.dups, hfdict.skipped, DICTBLOB_MAX_LEN);
+    return EXIT_SUCCESS;
+}